@@ -4,6 +4,10 @@
  * @author  Elmar Vonlanthen (vonle1@bfh.ch)
  * @date    Jun 2, 2011
  * @brief   Read buttons on CARME board over Sysfs-GPIOs
+ *
+ * The value files of the button GPIOs are opened once and read with
+ * pread(), so a button read costs one system call. The number of reads
+ * and system calls is counted and printed when the GPIOs are torn down.
  */
 
 #include <stdio.h>
@@ -11,11 +15,57 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <string.h>
+#include <time.h>
 
 #include "defines.h"
 #include "inputController.h"
+#include "pinConfig.h"
 #include "carme.h"
 
+/**
+ * Build the sysfs value file name of a GPIO at compile time
+ * (GPIO_NUMBER expands the GPIO macro before it is stringified)
+ */
+#define GPIO_VALUE_FILE(gpio) "/sys/class/gpio/gpio" GPIO_NUMBER(gpio) "/value"
+#define GPIO_NUMBER(gpio) #gpio
+
+/**
+ * The pins of the board, which are used over sysfs
+ */
+static const PinConfig carmePins[] = {
+	{ BUTTON_1_GPIO, pinFunction_gpio, pinDirection_in, pinLevel_low, FALSE },
+	{ BUTTON_2_GPIO, pinFunction_gpio, pinDirection_in, pinLevel_low, FALSE },
+	{ BUTTON_3_GPIO, pinFunction_gpio, pinDirection_in, pinLevel_low, FALSE },
+	{ BUTTON_4_GPIO, pinFunction_gpio, pinDirection_in, pinLevel_low, FALSE }
+};
+#define NUM_OF_CARME_PINS (sizeof(carmePins) / sizeof(carmePins[0]))
+
+/**
+ * A button GPIO
+ */
+typedef struct {
+	int gpio;                  /**< GPIO number */
+	UINT8 button;              /**< Button bit (BUTTON_1, ...) */
+	const char *valueFileName; /**< Name of the sysfs value file */
+	int valueFD;               /**< Value file descriptor or -1 */
+} ButtonGPIO;
+
+/**
+ * The button GPIOs
+ */
+static ButtonGPIO buttonGPIOs[] = {
+	{ BUTTON_1_GPIO, BUTTON_1, GPIO_VALUE_FILE(BUTTON_1_GPIO), -1 },
+	{ BUTTON_2_GPIO, BUTTON_2, GPIO_VALUE_FILE(BUTTON_2_GPIO), -1 },
+	{ BUTTON_3_GPIO, BUTTON_3, GPIO_VALUE_FILE(BUTTON_3_GPIO), -1 },
+	{ BUTTON_4_GPIO, BUTTON_4, GPIO_VALUE_FILE(BUTTON_4_GPIO), -1 }
+};
+#define NUM_OF_BUTTON_GPIOS (sizeof(buttonGPIOs) / sizeof(buttonGPIOs[0]))
+
+// Read statistics
+static unsigned long buttonReads = 0;
+static unsigned long valueReads = 0;
+static unsigned long systemCalls = 0;
+
 /**
  * GPIO export states
  */
@@ -54,79 +104,148 @@ static int exportGPIO(int id, enum GPIOExportValue val) {
 /**
  * @copydoc setGPIODirection
  */
-static int setGPIODirection(int id)
+static int setGPIODirection(const PinConfig *pin)
 {
 	int directionFD;
 	char directionFileName[50];
+	const char *direction;
 
-	/* Set direction to 'in' for reading its values */
-	sprintf(directionFileName, "/sys/class/gpio/gpio%d/direction", id);
+	/* An output is set to its level together with the direction, so it
+	 * does not glitch */
+	if (pin->direction == pinDirection_in) {
+		direction = "in";
+	} else if (pin->level == pinLevel_high) {
+		direction = "high";
+	} else {
+		direction = "low";
+	}
+	sprintf(directionFileName, "/sys/class/gpio/gpio%d/direction", (int) pin->gpio);
 	directionFD = open(directionFileName, O_WRONLY);
 	if (directionFD < 0) {
-		printf("Cannot open GPIO direction for %d\n", id);
+		printf("Cannot open GPIO direction for %d\n", (int) pin->gpio);
 		return FALSE;
 	}
-	write(directionFD, "in", 4);
+	write(directionFD, direction, strlen(direction));
 	close(directionFD);
 	return TRUE;
 }
 
 /**
- * @copydoc setUpButton
+ * @copydoc setUpPin
  */
-static int setUpButton(int id) {
-	/* Export button GPIO */
-	if (!exportGPIO(id, gpio_export)) {
+static int setUpPin(const PinConfig *pin) {
+	/* Export GPIO */
+	if (!exportGPIO(pin->gpio, gpio_export)) {
 		return FALSE;
 	}
-	/* Set button GPIO directions to in */
-	if (!setGPIODirection(id)) {
+	/* Set GPIO direction */
+	if (!setGPIODirection(pin)) {
 		return FALSE;
 	}
 	return TRUE;
 }
 
 /**
- * @copydoc readGPIOValue
+ * Read a GPIO value over the open value file
+ *
+ * @param buttonGPIO The button GPIO
+ * @return Returns the value (0 or 1) or -1 if it can't be read
  */
-static int readGPIOValue(int id) {
+static int readGPIOValue(ButtonGPIO *buttonGPIO) {
+	char value[2];
+
+	valueReads++;
+	systemCalls++;
+	// sysfs GPIO files have to be read from the beginning:
+	if (pread(buttonGPIO->valueFD, value, 2, 0) < 1) {
+		return -1;
+	}
+	return value[0] == '1' ? 1 : 0;
+}
+
+#ifdef DEBUG
+/**
+ * Read a GPIO value the way it was done before the value files were kept
+ * open (open, read and close per read). Only used for the comparison.
+ */
+static int readGPIOValueByName(const char *valueFileName) {
 	int valueFD;
-	char valueFileName[50];
-	char value[3];
+	char value[3] = "";
 
-	/* read value from gpio file in sysfs */
-	sprintf(valueFileName, "/sys/class/gpio/gpio%d/value", id);
 	valueFD = open(valueFileName, O_RDONLY);
 	if (valueFD < 0) {
-		printf("Cannot open GPIO value for %d\n", id);
 		return -1;
 	}
 	read(valueFD, value, 2);
 	close(valueFD);
 
-	/* return value as integer */
 	return atoi(value);
 }
 
+/**
+ * Get the monotonic time in nanoseconds
+ */
+static unsigned long long getTime(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Compare the time per read of both read methods and print it
+ */
+static void compareGPIOReads(void) {
+	const int numberOfReads = 1000;
+	unsigned long long startTime, byNameTime, openTime;
+
+	startTime = getTime();
+	for (int i = 0; i < numberOfReads; i++) {
+		readGPIOValueByName(buttonGPIOs[i % NUM_OF_BUTTON_GPIOS].valueFileName);
+	}
+	byNameTime = getTime() - startTime;
+
+	startTime = getTime();
+	for (int i = 0; i < numberOfReads; i++) {
+		readGPIOValue(&buttonGPIOs[i % NUM_OF_BUTTON_GPIOS]);
+	}
+	openTime = getTime() - startTime;
+	valueReads -= numberOfReads;
+	systemCalls -= numberOfReads;
+
+	printf("GPIO value read with open/read/close: 3 system calls, %llu ns\n", byNameTime / numberOfReads);
+	printf("GPIO value read with pread: 1 system call, %llu ns\n", openTime / numberOfReads);
+}
+#endif
+
 /**
  * @copydoc setUpCarmeGPIO
  */
 int setUpCarmeGPIO(void) {
 	int ret = TRUE;
 
-	/* Initialize all buttons */
-	if (!setUpButton(BUTTON_1)) {
-		ret = FALSE;
-	}
-	if (!setUpButton(BUTTON_2)) {
-		ret = FALSE;
+	/* Initialize all pins */
+	for (int i = 0; i < NUM_OF_CARME_PINS; i++) {
+		if (!setUpPin(&carmePins[i])) {
+			ret = FALSE;
+		}
 	}
-	if (!setUpButton(BUTTON_3)) {
-		ret = FALSE;
+
+	/* Open the value files of the buttons */
+	for (int i = 0; i < NUM_OF_BUTTON_GPIOS; i++) {
+		buttonGPIOs[i].valueFD = open(buttonGPIOs[i].valueFileName, O_RDONLY);
+		if (buttonGPIOs[i].valueFD < 0) {
+			printf("Cannot open GPIO value for %d\n", buttonGPIOs[i].gpio);
+			ret = FALSE;
+		}
 	}
-	if (!setUpButton(BUTTON_4)) {
-		ret = FALSE;
+	buttonReads = valueReads = systemCalls = 0;
+
+#ifdef DEBUG
+	if (ret) {
+		compareGPIOReads();
 	}
+#endif
 	return ret;
 }
 
@@ -136,25 +255,39 @@ int setUpCarmeGPIO(void) {
 int tearDownCarmeGPIO(void) {
 	int ret = TRUE;
 
-	/* unexport all GPIO buttons */
-	if (!exportGPIO(BUTTON_1, gpio_unexport)) {
-		ret = FALSE;
-	}
-	if (!exportGPIO(BUTTON_2, gpio_unexport)) {
-		ret = FALSE;
+#ifdef DEBUG
+	if (buttonReads) {
+		printf("GPIO buttons: %lu reads, %lu value reads, %lu system calls\n",
+				buttonReads, valueReads, systemCalls);
 	}
-	if (!exportGPIO(BUTTON_3, gpio_unexport)) {
-		ret = FALSE;
+#endif
+
+	/* close value files and unexport all pins */
+	for (int i = 0; i < NUM_OF_BUTTON_GPIOS; i++) {
+		if (buttonGPIOs[i].valueFD >= 0) {
+			close(buttonGPIOs[i].valueFD);
+			buttonGPIOs[i].valueFD = -1;
+		}
 	}
-	if (!exportGPIO(BUTTON_4, gpio_unexport)) {
-		ret = FALSE;
+	for (int i = 0; i < NUM_OF_CARME_PINS; i++) {
+		if (!exportGPIO(carmePins[i].gpio, gpio_unexport)) {
+			ret = FALSE;
+		}
 	}
 	return ret;
 }
 
 /**
- * @copydoc readGPIOButton
+ * @copydoc readGPIOButtons
  */
-int readGPIOButton(int id) {
-	return readGPIOValue(id);
+UINT8 readGPIOButtons(void) {
+	UINT8 buttons = 0;
+
+	buttonReads++;
+	for (int i = 0; i < NUM_OF_BUTTON_GPIOS; i++) {
+		if (readGPIOValue(&buttonGPIOs[i]) == 1) {
+			buttons |= buttonGPIOs[i].button;
+		}
+	}
+	return buttons;
 }
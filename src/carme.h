@@ -9,6 +9,8 @@
  * \remark  Last Modifications:
  * \remark  V1.0, AOM1, 28.08.07   Initial release
  * \remark  V1.1, 02.06.2011       Add GPIO functions
+ * \remark  V1.2, agent, 17.10.2026  Read all buttons at once
+ * \remark  V1.3, agent, 17.10.2026  Pins configured from a table
  * 
  ****************************************************************************
  */
@@ -16,6 +18,8 @@
 #ifndef CARME_H_
 #define CARME_H_
 
+#include "types.h"
+
 /*
  *******************************************************************************
  * Definitions
@@ -27,6 +31,11 @@
 #define LED_OFFSET		(0x3000)	/* Offset of led register in IO space */
 #define SWITCH_OFFSET	(0x3200)	/* Offset of switch register in IO space */
 
+#define BUTTON_1_GPIO	 99			/* GPIO numbers of the buttons */
+#define BUTTON_2_GPIO	101
+#define BUTTON_3_GPIO	102
+#define BUTTON_4_GPIO	103
+
 /*
  *******************************************************************************
  * Public Function Prototypes
@@ -36,7 +45,7 @@
 /**
  * Initializing GPIOs
  *
- * Exporting button GPIOs and setting direction to 'in'.
+ * Exporting the GPIOs of the pin table and setting their directions.
  *
  * @return Returns TRUE if initializing was successful
  */
@@ -45,18 +54,17 @@ extern int setUpCarmeGPIO();
 /**
  * Tearing down GPIOs
  *
- * Unexporting button GPIOs
+ * Unexporting the GPIOs of the pin table
  *
  * @return Returns TRUE if tearing down was successful
  */
 extern int tearDownCarmeGPIO();
 
 /**
- * Read button state over GPIO
+ * Read button states over GPIO
  *
- * @param id Button identifier
- * @return Returns state of button (on or off)
+ * @return Returns one bit per pressed button (BUTTON_1, ...)
  */
-extern int readGPIOButton(int id);
+extern UINT8 readGPIOButtons(void);
 
 #endif /* CARME_H_ */
@@ -14,6 +14,10 @@
  * @code
  * <user>@<host> $ make carme
  * @endcode
+ * for the host computer (simulated board with ORCHID layout):
+ * @code
+ * <user>@<host> $ make sim
+ * @endcode
  * @subsection step2 Step 2: Install files
  * for ORCHID:
  * @code
@@ -35,6 +39,25 @@
  * root@<target> # /usr/local/bin/yacm
  * @endcode
  * Be sure the speakers or headphones are plugged in.
+ *
+ * Options:
+ * @arg @b -r @e priority: Run the control loop in real-time mode with the
+ * given SCHED_FIFO priority (1 to 99, needs root privileges)
+ * @arg @b -c @e cpu: Pin the control loop to the given CPU (real-time mode only)
+ * @arg @b -b @e backend: Select the hardware backend (board or sim)
+ * @arg @b -s @e script: Run the simulated board with the given input
+ * script (see simulatedBoard.h)
+ * @arg @b -g @e chip:offsets: Read the buttons over the given GPIO
+ * character device lines (see gpioChardev.h, GPIO_CHARDEV builds only)
+ * @arg @b -d @e factor: Let the time run the given factor faster
+ * @arg @b -p @e state=rate: Set the polling rate in Hz of the given coffee
+ * maker state (off, initializing, idle or producing), may be repeated
+ * @arg @b -w @e threshold: Set the stall watchdog threshold in ms (0 disables
+ * the watchdog)
+ * @arg @b -l @e frequency: Set the PWM frequency in Hz of the dimmed LEDs
+ * (default 200, 0 shows them fully on)
+ * @arg @b -v: Let the time jump forward whenever there is nothing to do,
+ * so the application runs as fast as possible (e.g. for soak tests)
  * @subsection step4 Step 4: Simulate sensors
  * for ORCHID:
  * @arg @b S3: Coffee tank is empty
@@ -51,7 +74,6 @@
  *
  * @section knownProblems Known Problems
  * @arg Sound is not working on CARME board (mplayer doesn't work too!)
- * @arg Blinking of leds with same frequency is not synchronized
  * @arg Vncserver (fbvncserver &) on ORCHID board should be started manually before executing this application
  *
  * @section architecture Architecture
@@ -72,44 +94,105 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
-#include <signal.h>
+#include <string.h>
+#include <getopt.h>
 
 #include "defines.h"
+#include "eventLoop.h"
 #include "logic.h"
 #include "userInterface.h"
 #include "hardwareController.h"
+#include "simulatedBoard.h"
+#include "gpioChardev.h"
 #include "machineController.h"
 #include "inputController.h"
 #include "ledController.h"
+#include "ledSequencer.h"
+#include "segmentDisplay.h"
 #include "sensorController.h"
+#include "timebase.h"
 #include "timer.h"
+#include "loopStatistics.h"
+#include "realtime.h"
+#include "watchdog.h"
 
-static volatile int ctrlCPressed = FALSE;
+/**
+ * A polling rate of a coffee maker state.
+ * Inputs are sampled once per polling tick, in between the process sleeps.
+ * So a state only polls as fast as its inputs need to be watched.
+ */
+typedef struct {
+	CoffeeMakerState state; /**< The coffee maker state. */
+	char *name; /**< The name of the state used on the command line. */
+	unsigned int rate; /**< The polling rate in Hz. */
+} PollingRate;
 
-static void sigCtrlC(int sig)
-{
-	ctrlCPressed = TRUE;
-	(void) signal(SIGINT, SIG_DFL);
-}
+/**
+ * The polling rates.
+ */
+static PollingRate pollingRates[] = {
+	// Only the power switch is watched
+	{ .state = coffeeMaker_off, .name = "off", .rate = 20 },
+	{ .state = coffeeMaker_initializing, .name = "initializing", .rate = 50 },
+	// The buttons are watched
+	{ .state = coffeeMaker_idle, .name = "idle", .rate = 200 },
+	// The tank sensors are watched while delivering
+	{ .state = coffeeMaker_producing, .name = "producing", .rate = 1000 }
+};
+static const int numberOfPollingRates = sizeof(pollingRates) / sizeof(pollingRates[0]);
+static int currentPollingRate = -1;
+
+static int realtimePriority = 0;
+static int realtimeCPU = NO_CPU;
+static TIME watchdogThreshold = MILLISECONDS(250);
+static enum ClockMode clockMode = clock_real;
+static unsigned int clockDilation = 1;
 
+// What the subsystems saw on their last run (see runSubsystems())
+static int wasMachineForcedSafe = FALSE;
+// The first tick takes over the initial input states
+static int isRunPending = TRUE;
+
+static int parseOptions(int argc, char* argv[]);
+static int parsePollingRate(char *option);
+static void updatePollingRate();
 static void setUpSubsystems();
 static void tearDownSubsystems();
+static void runSubsystems();
 
 /**
  * The entry point of the application.
  */
 int main(int argc, char* argv[]) {
+	if (!parseOptions(argc, argv)) {
+		printf("Usage: %s [-r priority [-c cpu]] [-b backend] [-s script] [-g chip:offsets] [-d factor | -v] [-p state=rate]... [-w threshold] [-l frequency]\n", argv[0]);
+		exit(1);
+	}
+
+	// Must be set up before any timer is started
+	setUpClock(clockMode, clockDilation);
+
 	setUpSubsystems();
 
-	// set CTRL-C interrupt handler:
-	(void) signal(SIGINT, sigCtrlC);
+	registerTickHandler(&runSubsystems);
+	updatePollingRate();
 
-	while (!ctrlCPressed) {
-		// Propagate "heartbeat"
-		runUserInterface();
-		runBusinessLogic();
+	// Must be set up last, as threads started afterwards
+	// would inherit the real-time scheduling policy
+	if (realtimePriority) {
+		setUpRealtimeMode(realtimePriority, realtimeCPU);
+		// The LED PWM and the 7-segment display must not wait for a busy loop
+		setLedPwmPriority(realtimePriority < 98 ? realtimePriority + 1 : 98);
+		setSegmentDisplayPriority(realtimePriority < 98 ? realtimePriority + 1 : 98);
+		// The watchdog must be able to preempt a spinning loop
+		setWatchdogPriority(realtimePriority < 98 ? realtimePriority + 2 : 99);
 	}
 
+	// Sleep until the next polling tick or a termination signal (CTRL-C)
+	runEventLoop();
+
+	tearDownRealtimeMode();
+	printLoopStatistics();
 #ifdef DEBUG
 	printf("\nShutting down system...\n");
 #endif
@@ -120,14 +203,138 @@ int main(int argc, char* argv[]) {
 	exit(0);
 }
 
+/**
+ * Parses the command line options.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+int parseOptions(int argc, char* argv[]) {
+	int option;
+
+	while ((option = getopt(argc, argv, "r:c:b:s:g:d:vp:w:l:")) != -1) {
+		switch (option) {
+		case 'r':
+			realtimePriority = atoi(optarg);
+			if (realtimePriority < 1 || realtimePriority > 99) {
+				return FALSE;
+			}
+			break;
+		case 'c':
+			realtimeCPU = atoi(optarg);
+			if (realtimeCPU < 0) {
+				return FALSE;
+			}
+			break;
+		case 'b':
+			if (!selectHardwareBackend(optarg)) {
+				return FALSE;
+			}
+			break;
+		case 's':
+			selectHardwareBackend("sim");
+			setSimulationScript(optarg);
+			break;
+#ifdef GPIO_CHARDEV
+		case 'g':
+			if (!setGPIOButtonLines(optarg)) {
+				return FALSE;
+			}
+			selectHardwareBackend("gpiochip");
+			break;
+#endif
+		case 'd':
+			if (atoi(optarg) < 1) {
+				return FALSE;
+			}
+			clockMode = clock_dilated;
+			clockDilation = atoi(optarg);
+			break;
+		case 'v':
+			clockMode = clock_virtual;
+			break;
+		case 'w':
+			if (atoi(optarg) < 0) {
+				return FALSE;
+			}
+			watchdogThreshold = MILLISECONDS(atoi(optarg));
+			break;
+		case 'l':
+			if (atoi(optarg) < 0 || !setLedPwmFrequency(atoi(optarg))) {
+				return FALSE;
+			}
+			break;
+		case 'p':
+			if (!parsePollingRate(optarg)) {
+				return FALSE;
+			}
+			break;
+		default:
+			return FALSE;
+		}
+	}
+
+	return optind == argc;
+}
+
+/**
+ * Parses a polling rate option of the form state=rate.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+int parsePollingRate(char *option) {
+	char *rate = strchr(option, '=');
+
+	if (!rate || atoi(rate + 1) < 1) {
+		return FALSE;
+	}
+
+	for (int i = 0; i < numberOfPollingRates; i++) {
+		if (strncmp(pollingRates[i].name, option, rate - option) == 0
+			&& strlen(pollingRates[i].name) == (size_t) (rate - option)) {
+			pollingRates[i].rate = atoi(rate + 1);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * Applies the polling rate of the current coffee maker state
+ * if the state has changed.
+ */
+void updatePollingRate() {
+	CoffeeMakerState state = getCoffeeMakerViewModel().state;
+
+	if (currentPollingRate >= 0 && pollingRates[currentPollingRate].state == state) {
+		return;
+	}
+
+	for (int i = 0; i < numberOfPollingRates; i++) {
+		if (pollingRates[i].state == state) {
+#ifdef DEBUG
+			printf("Polling at %u Hz\n", pollingRates[i].rate);
+#endif
+			setPollingInterval(SECONDS(1) / pollingRates[i].rate);
+			currentPollingRate = i;
+			return;
+		}
+	}
+}
+
 /**
  * Sets up all subsystems.
  */
 void setUpSubsystems() {
+	// Must be set up first, as it blocks the termination signals
+	// for all threads started afterwards
+	setUpEventLoop();
+	if (watchdogThreshold) {
+		setUpWatchdog(watchdogThreshold);
+	}
 	setUpHardwareController();
 	setUpMachineController();
 	setUpInputController();
 	setUpLedController();
+	setUpLedSequencer();
+	setUpSegmentDisplay();
 	setUpSensorController();
 	setUpBusinessLogic();
 	setUpDisplay();
@@ -137,11 +344,47 @@ void setUpSubsystems() {
  * Tears down all subsystems.
  */
 void tearDownSubsystems() {
+	tearDownWatchdog();
 	tearDownDisplay();
 	tearDownBusinessLogic();
 	tearDownSensorController();
+	tearDownSegmentDisplay();
+	tearDownLedSequencer();
 	tearDownLedController();
 	tearDownInputController();
 	tearDownMachineController();
 	tearDownHardwareController();
+	tearDownEventLoop();
+}
+
+/**
+ * Propagates the "heartbeat" to all subsystems.
+ * Gets called once per polling tick. The inputs are sampled on every tick,
+ * but the user interface and the business logic only run if they have
+ * work: changed inputs or queued input events, a state changed by the
+ * timer handlers of the business logic or a machine forced safe by the
+ * watchdog. Other timers (e.g. the countdown of the work view) update their
+ * part of the user interface themselves.
+ */
+void runSubsystems() {
+	// The user interface and the business logic see the same inputs
+	int haveInputsChanged = takeInputSnapshot();
+
+	if (haveInputsChanged || isRunPending || isBusinessLogicRunPending()
+		|| isMachineForcedSafe() != wasMachineForcedSafe) {
+		CoffeeMakerState state = getCoffeeMakerViewModel().state;
+
+		wasMachineForcedSafe = isMachineForcedSafe();
+
+		setWatchdogPhase(watchdogPhase_userInterface);
+		runUserInterface();
+		setWatchdogPhase(watchdogPhase_businessLogic);
+		runBusinessLogic();
+
+		// The view of a new state checks the switch levels on its first run
+		isRunPending = getCoffeeMakerViewModel().state != state;
+	}
+
+	// The state may have changed
+	updatePollingRate();
 }
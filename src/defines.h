@@ -17,6 +17,13 @@
 	#define ORCHID
 #endif
 
+/**
+ * Define SIM to build for the host computer: The board (see above) only
+ * defines the layout of the inputs and LEDs, the simulated board is the
+ * only hardware backend.
+ */
+//#define SIM
+
 
 /**
  * Define symbol for the boolean value 'true'.
@@ -0,0 +1,399 @@
+/**
+ * @file   eventLoop.c
+ * @author agent (agent@local)
+ * @date   Oct 17, 2026
+ * @brief  Contains the event loop.
+ *
+ * The event loop blocks in epoll_wait() until either the wake-up timer
+ * (timerfd) expires, a watched file descriptor becomes readable or a
+ * termination signal (signalfd) arrives. The wake-up timer is armed with
+ * the earlier of the next polling tick and the next timer deadline (see
+ * timer.h). So the process does not consume any CPU time while there is
+ * nothing to do.
+ *
+ * The polling tick stays at a fixed rate on purpose: Most inputs can't
+ * wake the loop up (the switches and sensors are only readable levels), so
+ * they are sampled and debounced on every tick. The tick handler only runs
+ * the user interface and the business logic if a tick has brought them
+ * work (see runSubsystems() in controller.c).
+ *
+ * If the clock is virtual (see timebase.h), the loop does not sleep at all,
+ * but lets the time jump to the next wake-up time whenever there is no
+ * other event. So the application runs as fast as possible.
+ *
+ * The timing of every iteration is recorded in the loop statistics (see
+ * loopStatistics.h), which are printed on SIGUSR1.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+
+#include "defines.h"
+#include "timebase.h"
+#include "timer.h"
+#include "loopStatistics.h"
+#include "watchdog.h"
+#include "eventLoop.h"
+
+/**
+ * A watched file descriptor.
+ */
+typedef struct {
+	int fd; /**< The file descriptor or -1 if the entry is unused. */
+	HandleEvent handler; /**< The handler called if fd is readable. */
+} EventSource;
+
+/**
+ * A wake-up source.
+ */
+typedef struct {
+	GetWakeUpTime getWakeUpTime; /**< Gets the next wake-up time or NULL if the entry is unused. */
+	HandleWakeUp handler; /**< The handler called when the wake-up time has come. */
+	TIME wakeUpTime; /**< The wake-up time asked for before the loop slept. */
+} WakeUpSource;
+
+static EventSource eventSources[MAX_EVENT_SOURCES];
+static WakeUpSource wakeUpSources[MAX_WAKE_UP_SOURCES];
+static int epollFD = -1;
+static int timerFD = -1;
+static int signalFD = -1;
+static sigset_t handledSignals;
+static sigset_t terminationSignals;
+static HandleTick tickHandler;
+static TIME pollingInterval = NO_TIME;
+static TIME nextPollingTime = NO_TIME;
+static TIME wakeUpTime = NO_TIME;
+static volatile int isEventLoopRunning = FALSE;
+static int isEventLoopSetUp = FALSE;
+
+/**
+ * Handles an expiration of the wake-up timer.
+ */
+static void handleWakeUpTimer(int fd) {
+	uint64_t expirations;
+
+	// Just acknowledge the expiration, the work is done by the loop itself
+	read(fd, &expirations, sizeof(expirations));
+	wakeUpTime = NO_TIME;
+}
+
+/**
+ * Arms the wake-up timer for the earliest of the next polling tick, the
+ * next timer deadline and the next wake-up time of the wake-up sources.
+ */
+static void armWakeUpTimer(void) {
+	struct itimerspec timerSpec = { { 0, 0 }, { 0, 0 } };
+	TIME nextWakeUpTime = getNextTimerDeadline();
+
+	if (nextPollingTime < nextWakeUpTime) {
+		nextWakeUpTime = nextPollingTime;
+	}
+	for (int i = 0; i < MAX_WAKE_UP_SOURCES; i++) {
+		WakeUpSource *source = &wakeUpSources[i];
+
+		if (source->getWakeUpTime) {
+			source->wakeUpTime = (*source->getWakeUpTime)();
+			if (source->wakeUpTime < nextWakeUpTime) {
+				nextWakeUpTime = source->wakeUpTime;
+			}
+		}
+	}
+	// The virtual time is advanced by the loop itself
+	if (isClockVirtual()) {
+		wakeUpTime = nextWakeUpTime;
+		return;
+	}
+	// Avoid the system call if the wake-up time did not change
+	if (nextWakeUpTime == wakeUpTime) {
+		return;
+	}
+
+	// A zero value disarms the timer
+	if (nextWakeUpTime != NO_TIME) {
+		TIME systemTime = toSystemTime(nextWakeUpTime);
+
+		timerSpec.it_value.tv_sec = systemTime / SECONDS(1);
+		timerSpec.it_value.tv_nsec = systemTime % SECONDS(1);
+	}
+	if (timerfd_settime(timerFD, TFD_TIMER_ABSTIME, &timerSpec, NULL) < 0) {
+		perror("timerfd_settime()");
+		return;
+	}
+	wakeUpTime = nextWakeUpTime;
+}
+
+/**
+ * Handles a termination signal or a statistics request (SIGUSR1).
+ */
+static void handleSignal(int fd) {
+	struct signalfd_siginfo signalInfo;
+
+	if (read(fd, &signalInfo, sizeof(signalInfo)) != sizeof(signalInfo)) {
+		return;
+	}
+
+#ifdef DEBUG
+	printf("Received signal %d\n", signalInfo.ssi_signo);
+#endif
+	if (signalInfo.ssi_signo == SIGUSR1) {
+		printLoopStatistics();
+		return;
+	}
+
+	stopEventLoop();
+
+	// A second CTRL-C terminates the process immediately
+	sigprocmask(SIG_UNBLOCK, &terminationSignals, NULL);
+}
+
+/**
+ * @copydoc setUpEventLoop
+ */
+int setUpEventLoop(void) {
+	// Check if event loop is already set up
+	if (isEventLoopSetUp) {
+		return FALSE;
+	}
+
+	for (int i = 0; i < MAX_EVENT_SOURCES; i++) {
+		eventSources[i].fd = -1;
+		eventSources[i].handler = NULL;
+	}
+
+	epollFD = epoll_create(MAX_EVENT_SOURCES);
+	if (epollFD < 0) {
+		perror("epoll_create()");
+		return FALSE;
+	}
+
+	// Signals are received over a file descriptor. Threads started
+	// later on (e.g. by SDL) inherit the signal mask.
+	sigemptyset(&terminationSignals);
+	sigaddset(&terminationSignals, SIGINT);
+	sigaddset(&terminationSignals, SIGTERM);
+	handledSignals = terminationSignals;
+	sigaddset(&handledSignals, SIGUSR1);
+	sigprocmask(SIG_BLOCK, &handledSignals, NULL);
+	signalFD = signalfd(-1, &handledSignals, 0);
+	if (signalFD < 0) {
+		perror("signalfd()");
+		return FALSE;
+	}
+
+	timerFD = timerfd_create(CLOCK_MONOTONIC, 0);
+	if (timerFD < 0) {
+		perror("timerfd_create()");
+		return FALSE;
+	}
+
+	isEventLoopSetUp = TRUE;
+
+	addEventSource(signalFD, &handleSignal);
+	addEventSource(timerFD, &handleWakeUpTimer);
+
+	return TRUE;
+}
+
+/**
+ * @copydoc tearDownEventLoop
+ */
+int tearDownEventLoop(void) {
+	// Check if event loop was already torn down
+	if (!isEventLoopSetUp) {
+		return FALSE;
+	}
+
+	close(timerFD);
+	close(signalFD);
+	close(epollFD);
+	timerFD = signalFD = epollFD = -1;
+	sigprocmask(SIG_UNBLOCK, &handledSignals, NULL);
+
+	isEventLoopSetUp = FALSE;
+	return TRUE;
+}
+
+/**
+ * @copydoc setPollingInterval
+ */
+int setPollingInterval(TIME interval) {
+	if (!isEventLoopSetUp || interval == 0) {
+		return FALSE;
+	}
+
+	pollingInterval = interval;
+	nextPollingTime = getCurrentTime() + interval;
+	return TRUE;
+}
+
+/**
+ * @copydoc registerTickHandler
+ */
+void registerTickHandler(HandleTick pHandler) {
+	tickHandler = pHandler;
+}
+
+/**
+ * @copydoc addEventSource
+ */
+int addEventSource(int fd, HandleEvent pHandler) {
+	struct epoll_event event;
+
+	if (!isEventLoopSetUp) {
+		return FALSE;
+	}
+
+	for (int i = 0; i < MAX_EVENT_SOURCES; i++) {
+		if (eventSources[i].fd < 0) {
+			event.events = EPOLLIN;
+			event.data.ptr = &eventSources[i];
+			if (epoll_ctl(epollFD, EPOLL_CTL_ADD, fd, &event) < 0) {
+				perror("epoll_ctl()");
+				return FALSE;
+			}
+			eventSources[i].fd = fd;
+			eventSources[i].handler = pHandler;
+			return TRUE;
+		}
+	}
+	printf("Too many event sources!\n");
+	return FALSE;
+}
+
+/**
+ * @copydoc removeEventSource
+ */
+int removeEventSource(int fd) {
+	if (!isEventLoopSetUp) {
+		return FALSE;
+	}
+
+	for (int i = 0; i < MAX_EVENT_SOURCES; i++) {
+		if (eventSources[i].fd == fd) {
+			epoll_ctl(epollFD, EPOLL_CTL_DEL, fd, NULL);
+			eventSources[i].fd = -1;
+			eventSources[i].handler = NULL;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * @copydoc addWakeUpSource
+ */
+int addWakeUpSource(GetWakeUpTime pGetWakeUpTime, HandleWakeUp pHandler) {
+	for (int i = 0; i < MAX_WAKE_UP_SOURCES; i++) {
+		if (!wakeUpSources[i].getWakeUpTime) {
+			wakeUpSources[i].getWakeUpTime = pGetWakeUpTime;
+			wakeUpSources[i].handler = pHandler;
+			wakeUpSources[i].wakeUpTime = NO_TIME;
+			return TRUE;
+		}
+	}
+	printf("Too many wake-up sources\n");
+	return FALSE;
+}
+
+/**
+ * @copydoc removeWakeUpSource
+ */
+int removeWakeUpSource(GetWakeUpTime pGetWakeUpTime) {
+	for (int i = 0; i < MAX_WAKE_UP_SOURCES; i++) {
+		if (wakeUpSources[i].getWakeUpTime == pGetWakeUpTime) {
+			wakeUpSources[i].getWakeUpTime = NULL;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * @copydoc runEventLoop
+ */
+void runEventLoop(void) {
+	struct epoll_event events[MAX_EVENT_SOURCES];
+	TIME lastIterationTime = NO_TIME;
+
+	if (!isEventLoopSetUp) {
+		return;
+	}
+
+	isEventLoopRunning = TRUE;
+	while (isEventLoopRunning) {
+		// Sleep until there is something to do
+		armWakeUpTimer();
+		TIME scheduledTime = wakeUpTime;
+		setWatchdogPhase(watchdogPhase_sleeping);
+		int numberOfEvents = epoll_wait(epollFD, events, MAX_EVENT_SOURCES, isClockVirtual() ? 0 : -1);
+		if (numberOfEvents < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("epoll_wait()");
+			break;
+		}
+		if (numberOfEvents == 0) {
+			advanceVirtualTime(scheduledTime);
+		}
+
+		// Read the clock once for this iteration
+		TIME now = updateCurrentTime();
+		if (now >= scheduledTime) {
+			recordLoopStatistic(loopStatistic_wakeUpLatency, now - scheduledTime);
+		}
+		if (lastIterationTime != NO_TIME) {
+			recordLoopStatistic(loopStatistic_iterationGap, now - lastIterationTime);
+		}
+		lastIterationTime = now;
+
+		feedWatchdog();
+		setWatchdogPhase(watchdogPhase_timers);
+		updateTimers();
+
+		for (int i = 0; i < MAX_WAKE_UP_SOURCES; i++) {
+			WakeUpSource *source = &wakeUpSources[i];
+
+			if (source->getWakeUpTime && now >= source->wakeUpTime) {
+				(*source->handler)();
+			}
+		}
+
+		setWatchdogPhase(watchdogPhase_eventSources);
+		for (int i = 0; i < numberOfEvents; i++) {
+			EventSource *source = events[i].data.ptr;
+			// The source may have been removed by a previous handler
+			if (source->fd >= 0 && source->handler) {
+				(*source->handler)(source->fd);
+			}
+		}
+
+		if (now >= nextPollingTime) {
+			// Missed ticks are not caught up
+			nextPollingTime += pollingInterval;
+			if (nextPollingTime <= now) {
+				nextPollingTime = now + pollingInterval;
+			}
+
+			if (tickHandler) {
+				(*tickHandler)();
+			}
+		}
+
+		recordLoopStatistic(loopStatistic_iterationDuration, updateCurrentTime() - now);
+	}
+	setWatchdogPhase(watchdogPhase_sleeping);
+}
+
+/**
+ * @copydoc stopEventLoop
+ */
+void stopEventLoop(void) {
+	isEventLoopRunning = FALSE;
+}
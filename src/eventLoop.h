@@ -0,0 +1,123 @@
+/**
+ * Event loop
+ *
+ * Sleeps until there is something to do (a polling tick, a readable
+ * file descriptor or a signal) and dispatches it. Sending SIGUSR1 to the
+ * process prints the loop statistics.
+ *
+ * @file    eventLoop.h
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#ifndef EVENTLOOP_H_
+#define EVENTLOOP_H_
+
+#include "timebase.h"
+
+/**
+ * Maximum number of file descriptors the event loop can watch
+ * (including its internal wake-up timer and signal descriptors).
+ */
+#define MAX_EVENT_SOURCES 8
+
+/**
+ * Maximum number of wake-up sources the event loop can ask for
+ * their next wake-up time.
+ */
+#define MAX_WAKE_UP_SOURCES 4
+
+/**
+ * A handler which will be called if a watched file descriptor is readable.
+ * @param fd The readable file descriptor.
+ */
+typedef void (*HandleEvent)(int fd);
+
+/**
+ * A handler which will be called on every polling tick.
+ */
+typedef void (*HandleTick)();
+
+/**
+ * Gets the next time a wake-up source has to be handled.
+ * @return The next wake-up time or NO_TIME if there is none.
+ */
+typedef TIME (*GetWakeUpTime)(void);
+
+/**
+ * A handler which will be called if the wake-up time of a wake-up
+ * source has come.
+ */
+typedef void (*HandleWakeUp)(void);
+
+/**
+ * Sets up the event loop.
+ * Blocks the handled signals, so it has to be called before any
+ * other thread is started.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+extern int setUpEventLoop(void);
+
+/**
+ * Tears down the event loop.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+extern int tearDownEventLoop(void);
+
+/**
+ * Sets the polling interval.
+ * @param interval The polling interval.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+extern int setPollingInterval(TIME interval);
+
+/**
+ * Registers the polling tick handler.
+ * @param pHandler The handler which will be called on every polling tick.
+ */
+extern void registerTickHandler(HandleTick pHandler);
+
+/**
+ * Adds a file descriptor to the watched event sources.
+ * @param fd The file descriptor.
+ * @param pHandler The handler which will be called if fd is readable.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+extern int addEventSource(int fd, HandleEvent pHandler);
+
+/**
+ * Removes a file descriptor from the watched event sources.
+ * @param fd The file descriptor.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+extern int removeEventSource(int fd);
+
+/**
+ * Adds a wake-up source, which computes its own wake-up times
+ * (e.g. from a shared clock) instead of using timers.
+ * @param pGetWakeUpTime Gets the next wake-up time of the source.
+ * @param pHandler The handler which will be called when the wake-up time has come.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+extern int addWakeUpSource(GetWakeUpTime pGetWakeUpTime, HandleWakeUp pHandler);
+
+/**
+ * Removes a wake-up source.
+ * @param pGetWakeUpTime The function the source was added with.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+extern int removeWakeUpSource(GetWakeUpTime pGetWakeUpTime);
+
+/**
+ * Runs the event loop until it is stopped.
+ */
+extern void runEventLoop(void);
+
+/**
+ * Stops the event loop.
+ * The loop returns after the currently dispatched events are handled.
+ */
+extern void stopEventLoop(void);
+
+#endif /* EVENTLOOP_H_ */
@@ -0,0 +1,173 @@
+/**
+ * @brief   Read buttons over the GPIO character device
+ * @file    gpioChardev.c
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#ifdef GPIO_CHARDEV
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#include "defines.h"
+#include "types.h"
+#include "timebase.h"
+#include "eventLoop.h"
+#include "loopStatistics.h"
+#include "gpioChardev.h"
+
+/**
+ * Number of button lines (BUTTON_1 to BUTTON_4)
+ */
+#define NUM_OF_BUTTON_LINES 4
+
+static char chipName[64] = "/dev/gpiochip0";
+static unsigned int lineOffsets[NUM_OF_BUTTON_LINES] = { 0, 1, 2, 3 };
+static int requestFD = -1;
+
+// Buttons with an edge since the last read and the kernel timestamps of the
+// first edges
+static UINT8 latchedButtons = 0;
+static UINT64 edgeTimes[NUM_OF_BUTTON_LINES];
+
+/**
+ * Handle the edge events of the button lines
+ */
+static void handleButtonEdges(int fd) {
+	struct gpio_v2_line_event events[16];
+	ssize_t size = read(fd, events, sizeof(events));
+
+	for (int i = 0; i < size / (ssize_t) sizeof(events[0]); i++) {
+		for (int line = 0; line < NUM_OF_BUTTON_LINES; line++) {
+			if (events[i].offset == lineOffsets[line]) {
+				// keep the first edge since the last read
+				if (!(latchedButtons & (1 << line))) {
+					latchedButtons |= 1 << line;
+					edgeTimes[line] = events[i].timestamp_ns;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @copydoc setGPIOButtonLines
+ */
+int setGPIOButtonLines(const char *lines) {
+	const char *offsets = strrchr(lines, ':');
+	unsigned int parsedOffsets[NUM_OF_BUTTON_LINES];
+
+	if (!offsets || offsets - lines >= sizeof(chipName)) {
+		return FALSE;
+	}
+	if (sscanf(offsets + 1, "%u,%u,%u,%u", &parsedOffsets[0], &parsedOffsets[1],
+			&parsedOffsets[2], &parsedOffsets[3]) != NUM_OF_BUTTON_LINES) {
+		return FALSE;
+	}
+
+	memcpy(chipName, lines, offsets - lines);
+	chipName[offsets - lines] = '\0';
+	memcpy(lineOffsets, parsedOffsets, sizeof(lineOffsets));
+	return TRUE;
+}
+
+/**
+ * @copydoc setUpGPIOButtons
+ */
+int setUpGPIOButtons(void) {
+	struct gpio_v2_line_request request;
+	int chipFD;
+
+	chipFD = open(chipName, O_RDONLY);
+	if (chipFD < 0) {
+		printf("Cannot open GPIO chip %s\n", chipName);
+		return FALSE;
+	}
+
+	// one request for all button lines, as inputs with edge detection:
+	memset(&request, 0, sizeof(request));
+	memcpy(request.offsets, lineOffsets, sizeof(lineOffsets));
+	request.num_lines = NUM_OF_BUTTON_LINES;
+	strcpy(request.consumer, "yacm");
+	request.config.flags = GPIO_V2_LINE_FLAG_INPUT
+			| GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+	if (ioctl(chipFD, GPIO_V2_GET_LINE_IOCTL, &request) < 0) {
+		perror("ioctl(GPIO_V2_GET_LINE_IOCTL)");
+		close(chipFD);
+		return FALSE;
+	}
+	close(chipFD);
+
+	requestFD = request.fd;
+	fcntl(requestFD, F_SETFL, O_NONBLOCK);
+	latchedButtons = 0;
+	if (!addEventSource(requestFD, &handleButtonEdges)) {
+		close(requestFD);
+		requestFD = -1;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * @copydoc tearDownGPIOButtons
+ */
+int tearDownGPIOButtons(void) {
+	if (requestFD < 0) {
+		return FALSE;
+	}
+	removeEventSource(requestFD);
+	close(requestFD);
+	requestFD = -1;
+	return TRUE;
+}
+
+/**
+ * @copydoc readGPIOChardevButtons
+ */
+UINT8 readGPIOChardevButtons(void) {
+	struct gpio_v2_line_values values = {
+		.bits = 0,
+		.mask = (1 << NUM_OF_BUTTON_LINES) - 1
+	};
+
+	// the bits of the values are in the order of the requested lines:
+	if (ioctl(requestFD, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0) {
+		return 0;
+	}
+	return (UINT8) values.bits;
+}
+
+/**
+ * @copydoc readGPIOChardevButtonEdges
+ */
+UINT8 readGPIOChardevButtonEdges(void) {
+	UINT8 edges = latchedButtons;
+
+	// record how long it took from the edge until it is read (the edge
+	// timestamps are taken from CLOCK_MONOTONIC):
+	if (edges) {
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		for (int line = 0; line < NUM_OF_BUTTON_LINES; line++) {
+			if (edges & (1 << line)) {
+				recordLoopStatistic(loopStatistic_inputLatency,
+						SECONDS(ts.tv_sec) + NANOSECONDS(ts.tv_nsec) - edgeTimes[line]);
+			}
+		}
+		latchedButtons = 0;
+	}
+
+	return edges;
+}
+
+#endif /* GPIO_CHARDEV */
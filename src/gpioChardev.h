@@ -0,0 +1,74 @@
+/**
+ * @brief   Read buttons over the GPIO character device
+ *
+ * Reads the buttons over the GPIO character device interface (uAPI v2,
+ * Linux 5.10 and later) instead of sysfs: All button lines are requested
+ * at once, read with one ioctl() and their edges are delivered with kernel
+ * timestamps over a file descriptor, which is watched by the event loop.
+ * So a press shorter than a polling interval is not lost.
+ *
+ * Only compiled if GPIO_CHARDEV is defined. It can be tried on any Linux
+ * computer with a gpio-sim chip:
+ * @code
+ * # modprobe gpio-sim
+ * # mkdir -p /sys/kernel/config/gpio-sim/yacm/bank0
+ * # echo 4 > /sys/kernel/config/gpio-sim/yacm/bank0/num_lines
+ * # echo 1 > /sys/kernel/config/gpio-sim/yacm/live
+ * $ ./yacm_sim -g /dev/gpiochipN:0,1,2,3
+ * # echo pull-up > /sys/devices/platform/gpio-sim.0/gpiochipN/sim_gpio3/pull
+ * @endcode
+ *
+ * Without a GPIO chip, "make test" checks it against a stand-in for the chip
+ * (test/gpioChardevTest.c).
+ *
+ * @file    gpioChardev.h
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#ifndef GPIOCHARDEV_H_
+#define GPIOCHARDEV_H_
+
+#include "types.h"
+
+/**
+ * Set the button lines
+ *
+ * Has to be called before the buttons are set up.
+ *
+ * @param lines Chip device and the line offsets of BUTTON_1 to BUTTON_4,
+ * e.g. "/dev/gpiochip0:0,1,2,3"
+ * @return Returns TRUE if the lines could be parsed
+ */
+extern int setGPIOButtonLines(const char *lines);
+
+/**
+ * Request the button lines and watch their edges
+ *
+ * @return Returns TRUE if successful
+ */
+extern int setUpGPIOButtons(void);
+
+/**
+ * Release the button lines
+ *
+ * @return Returns TRUE if successful
+ */
+extern int tearDownGPIOButtons(void);
+
+/**
+ * Read button states
+ *
+ * @return Returns one bit per pressed button (BUTTON_1, ...)
+ */
+extern UINT8 readGPIOChardevButtons(void);
+
+/**
+ * Read and clear the button edges since the last call
+ *
+ * @return Returns one bit per button with an edge (BUTTON_1, ...)
+ */
+extern UINT8 readGPIOChardevButtonEdges(void);
+
+#endif /* GPIOCHARDEV_H_ */
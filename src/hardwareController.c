@@ -1,5 +1,5 @@
 /**
- * @brief   Initialize memory mapping and gpio's
+ * @brief   Hardware abstraction layer
  * @file    hardwareController.c
  * @version 1.0
  * @author  Elmar Vonlanthen (vonle1@bfh.ch)
@@ -8,13 +8,17 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <fcntl.h>
+#include <pthread.h>
 
 #include "defines.h"
 #include "types.h"
 #include "hardwareController.h"
+#include "simulatedBoard.h"
+#include "gpioChardev.h"
 
 #ifdef CARME
  #include "carme.h"
@@ -36,23 +40,26 @@
 
 // needs to be global for carme.c or orchid.c
 void *mmap_base = NULL;
+// needs to be global for orchid.c (OS timer of the ORCHID board)
+void *timer_base = NULL;
 
 /**
  * Local module specific variables
  */
-static int fd_mem;
-static off_t io_base = IO_BASE;
 static int isHardwareSetUp = FALSE;
 
+#ifndef SIM
+static int fd_mem;
+
 /**
- * @copydoc setUpHardwareController
+ * Set up the board
+ *
+ * Maps the IO memory and initializes the GPIOs.
+ *
+ * @return Returns TRUE if successful
  */
-int setUpHardwareController(void)
+static int setUpBoard(void)
 {
-	// Check if hardware controller is already setup
-	if (isHardwareSetUp) {
-		return FALSE;
-	}
 	// Try to open the mem device special file
 	if ((fd_mem = open(MEM_DEV, O_RDWR | O_SYNC)) < 1) {
 		perror("open(\"/dev/mem\")");
@@ -65,7 +72,7 @@ int setUpHardwareController(void)
 				PROT_READ | PROT_WRITE, // Allow read and write
 				MAP_SHARED,				// Share this mapping with all processes
 				fd_mem,					// Device is /dev/mem
-				io_base);				// IO memory region base
+				IO_BASE);				// IO memory region base
 
 	// check if memory is successfully mapped:
 	if (mmap_base == (void*) -1) {
@@ -78,7 +85,251 @@ int setUpHardwareController(void)
 	setUpCarmeGPIO();
 #elif defined(ORCHID)
 	GPIO_init();
+
+	// Map the OS timer, which is used to wait for the switch/button mux:
+	timer_base = mmap(NULL, MAP_SIZE, PROT_READ, MAP_SHARED, fd_mem, OST_BASE);
+	if (timer_base == (void*) -1) {
+		perror("mmap()");
+		timer_base = NULL;
+		return FALSE;
+	}
+
+	// Find the shortest reliable settle time of the mux:
+	UINT32 settleTicks = GPIO_calibrate_mux();
+	if (settleTicks) {
+		printf("Mux settle time: %lu ns\n", settleTicks * 1000000 / OSCR_TICKS_PER_MS);
+	} else {
+		printf("Mux settle time not calibrated (inputs changed or switches read as buttons), reading twice\n");
+	}
+#endif
+	return TRUE;
+}
+
+/**
+ * Tear down the board
+ *
+ * @return Returns TRUE if successful
+ */
+static int tearDownBoard(void)
+{
+	// unmap memory and free filedescriptor:
+	munmap(mmap_base, MAP_SIZE);
+#ifdef ORCHID
+	if (timer_base) {
+		munmap(timer_base, MAP_SIZE);
+		timer_base = NULL;
+	}
+#endif
+	close(fd_mem);
+#ifdef CARME
+	// tear down GPIO button configuration if CARME board:
+	tearDownCarmeGPIO();
+#endif
+	return TRUE;
+}
+
+/**
+ * Read the switches of the board
+ */
+static UINT8 readBoardSwitches(void)
+{
+#ifdef CARME
+	return *(volatile unsigned char *) (mmap_base + SWITCH_OFFSET);
+#elif defined(ORCHID)
+	// lets the mux settle (calibrated wait or a second read):
+	return GPIO_read_switch();
+#endif
+}
+
+/**
+ * Read the buttons of the board
+ */
+static UINT8 readBoardButtons(void)
+{
+#ifdef CARME
+	// on CARME board we read each single button state directly over GPIO
+	return readGPIOButtons();
+#elif defined(ORCHID)
+	// lets the mux settle (calibrated wait or a second read):
+	return GPIO_read_button();
 #endif
+}
+
+#ifdef ORCHID
+/**
+ * Read the button edges latched by the board
+ */
+static UINT8 readBoardButtonEdges(void)
+{
+	return GPIO_read_button_edges();
+}
+#endif
+
+/**
+ * Set the LEDs of the board
+ */
+static void writeBoardLeds(UINT8 pattern)
+{
+#ifdef CARME
+	*(volatile unsigned char *) (mmap_base + LED_OFFSET) = pattern;
+#elif defined(ORCHID)
+	GPIO_write_led(pattern);
+#endif
+}
+
+#ifdef ORCHID_SEGMENT_DISPLAY
+/**
+ * Show a digit of the 7-segment display of the board
+ */
+static void writeBoardDigit(int digit, UINT8 segments)
+{
+	GPIO_write_digit(digit, segments);
+}
+#endif
+
+/**
+ * Set the actuators of the board
+ */
+static void writeBoardActuators(UINT8 actuators)
+{
+	// no actuators are wired on the boards, the output is the sound only
+}
+
+/**
+ * The real board
+ */
+static const HardwareBackend board = {
+	.name = "board",
+	.setUp = setUpBoard,
+	.tearDown = tearDownBoard,
+	.readSwitches = readBoardSwitches,
+	.readButtons = readBoardButtons,
+#ifdef ORCHID
+	.readButtonEdges = readBoardButtonEdges,
+#endif
+	// the sensors are connected to the switch inputs:
+	.readSensors = readBoardSwitches,
+	.writeLeds = writeBoardLeds,
+	// the display is off until it is verified on the board that the LEDs
+	// are off while GPIO 118 is low (build with -DORCHID_SEGMENT_DISPLAY):
+#ifdef ORCHID_SEGMENT_DISPLAY
+	.writeDigit = writeBoardDigit,
+#endif
+	.writeActuators = writeBoardActuators
+};
+#endif
+
+#ifdef GPIO_CHARDEV
+/**
+ * The backend the GPIO character device buttons are combined with
+ */
+#ifndef SIM
+ #define BASE_BACKEND board
+#else
+ #define BASE_BACKEND simulatedBoard
+#endif
+
+/**
+ * Set up the board with buttons over the GPIO character device
+ */
+static int setUpGPIOChardevBoard(void)
+{
+	if (!BASE_BACKEND.setUp()) {
+		return FALSE;
+	}
+	if (!setUpGPIOButtons()) {
+		BASE_BACKEND.tearDown();
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Tear down the board with buttons over the GPIO character device
+ */
+static int tearDownGPIOChardevBoard(void)
+{
+	tearDownGPIOButtons();
+	return BASE_BACKEND.tearDown();
+}
+
+/**
+ * The board (or the simulated board on the host computer) with buttons
+ * over the GPIO character device
+ */
+static HardwareBackend gpioChardevBoard = {
+	.name = "gpiochip",
+	.setUp = setUpGPIOChardevBoard,
+	.tearDown = tearDownGPIOChardevBoard,
+	.readButtons = readGPIOChardevButtons,
+	.readButtonEdges = readGPIOChardevButtonEdges
+};
+#endif
+
+/**
+ * Available hardware backends, the first one is the default
+ */
+static const HardwareBackend *backends[] = {
+#ifndef SIM
+	&board,
+#endif
+	&simulatedBoard,
+#ifdef GPIO_CHARDEV
+	&gpioChardevBoard
+#endif
+};
+
+static const HardwareBackend *backend = NULL;
+
+// the LEDs and the 7-segment display share the port of the ORCHID board:
+static pthread_mutex_t portMutex = PTHREAD_MUTEX_INITIALIZER;
+static UINT8 ledPattern = 0;
+static int isLedPortShared = FALSE;
+
+/**
+ * @copydoc selectHardwareBackend
+ */
+int selectHardwareBackend(const char *name)
+{
+	// the backend can't be changed while it is in use:
+	if (isHardwareSetUp) {
+		return FALSE;
+	}
+
+	for (int i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+		if (strcmp(backends[i]->name, name) == 0) {
+			backend = backends[i];
+			return TRUE;
+		}
+	}
+	printf("Unknown hardware backend: %s\n", name);
+	return FALSE;
+}
+
+/**
+ * @copydoc setUpHardwareController
+ */
+int setUpHardwareController(void)
+{
+	// Check if hardware controller is already setup
+	if (isHardwareSetUp) {
+		return FALSE;
+	}
+	if (!backend) {
+		backend = backends[0];
+	}
+#ifdef GPIO_CHARDEV
+	// all but the buttons are taken from the base backend:
+	gpioChardevBoard.readSwitches = BASE_BACKEND.readSwitches;
+	gpioChardevBoard.readSensors = BASE_BACKEND.readSensors;
+	gpioChardevBoard.writeLeds = BASE_BACKEND.writeLeds;
+	gpioChardevBoard.writeDigit = BASE_BACKEND.writeDigit;
+	gpioChardevBoard.writeActuators = BASE_BACKEND.writeActuators;
+#endif
+
+	if (!backend->setUp()) {
+		return FALSE;
+	}
 
 	isHardwareSetUp = TRUE;
 	return TRUE;
@@ -93,13 +344,7 @@ int tearDownHardwareController(void)
 	if (!isHardwareSetUp) {
 		return FALSE;
 	}
-	// unmap memory and free filedescriptor:
-	munmap(mmap_base, MAP_SIZE);
-	close(fd_mem);
-#ifdef CARME
-	// tear down GPIO button configuration if CARME board:
-	tearDownCarmeGPIO();
-#endif
+	backend->tearDown();
 	isHardwareSetUp = FALSE;
 	return TRUE;
 }
@@ -111,3 +356,100 @@ int getHardwareSetUpState(void)
 {
 	return isHardwareSetUp;
 }
+
+/**
+ * @copydoc readInputs
+ */
+InputSnapshot readInputs(InputSnapshot *edges)
+{
+	UINT8 switches, buttons, sensors;
+
+	*edges = 0;
+	if (!isHardwareSetUp) {
+		return 0;
+	}
+
+	// the edges have to be read before the inputs, as reading the inputs
+	// may cause edges (e.g. the switch/button mux of the ORCHID board):
+	if (backend->readButtonEdges) {
+		*edges = (InputSnapshot) backend->readButtonEdges() << SNAPSHOT_BUTTONS_SHIFT;
+	}
+
+	switches = backend->readSwitches();
+	buttons = backend->readButtons();
+	if (backend->readSensors == backend->readSwitches) {
+		sensors = switches;
+	} else {
+		sensors = backend->readSensors();
+	}
+
+	return (InputSnapshot) switches << SNAPSHOT_SWITCHES_SHIFT
+			| (InputSnapshot) buttons << SNAPSHOT_BUTTONS_SHIFT
+			| (InputSnapshot) sensors << SNAPSHOT_SENSORS_SHIFT;
+}
+
+/**
+ * @copydoc writeLeds
+ */
+void writeLeds(UINT8 pattern)
+{
+	pthread_mutex_lock(&portMutex);
+	ledPattern = pattern;
+	// while the port is shared, the LEDs are shown in their slot only:
+	if (!isLedPortShared) {
+		backend->writeLeds(pattern);
+	}
+	pthread_mutex_unlock(&portMutex);
+}
+
+/**
+ * @copydoc shareLedPort
+ */
+void shareLedPort(int isShared)
+{
+	pthread_mutex_lock(&portMutex);
+	isLedPortShared = isShared;
+	if (!isShared) {
+		backend->writeLeds(ledPattern);
+	}
+	pthread_mutex_unlock(&portMutex);
+}
+
+/**
+ * @copydoc showLeds
+ */
+void showLeds(void)
+{
+	pthread_mutex_lock(&portMutex);
+	backend->writeLeds(ledPattern);
+	pthread_mutex_unlock(&portMutex);
+}
+
+/**
+ * @copydoc hasSegmentDisplay
+ */
+int hasSegmentDisplay(void)
+{
+	return isHardwareSetUp && backend->writeDigit != NULL;
+}
+
+/**
+ * @copydoc writeDigit
+ */
+void writeDigit(int digit, UINT8 segments)
+{
+	pthread_mutex_lock(&portMutex);
+	backend->writeDigit(digit, segments);
+	pthread_mutex_unlock(&portMutex);
+}
+
+/**
+ * @copydoc writeActuators
+ */
+void writeActuators(UINT8 actuators)
+{
+	// the watchdog may call it after the hardware was torn down:
+	if (isHardwareSetUp) {
+		backend->writeActuators(actuators);
+	}
+}
@@ -1,5 +1,12 @@
 /**
- * @brief   Initialize memory mapping and gpio's
+ * @brief   Hardware abstraction layer
+ *
+ * All accesses to the inputs, sensors, LEDs and actuators go through a
+ * hardware backend, which is selected at startup: Either the real board
+ * (CARME or ORCHID, depending on the build) or a simulated board (see
+ * simulatedBoard.h). The meaning of the bits (e.g. which switch is the
+ * power switch) is the same for both backends.
+ *
  * @file    hardwareController.h
  * @version 1.0
  * @author  Elmar Vonlanthen (vonle1@bfh.ch)
@@ -9,11 +16,57 @@
 #ifndef HARDWARECONTROLLER_H_
 #define HARDWARECONTROLLER_H_
 
+#include "types.h"
+
+/**
+ * Define actuators
+ */
+#define ACTUATOR_COFFEE		(1 << 0)
+#define ACTUATOR_MILK		(1 << 1)
+
+/**
+ * The states of all switches, buttons and sensors packed into one value
+ */
+typedef UINT32 InputSnapshot;
+
+/**
+ * Positions of the switches, buttons and sensors in an input snapshot
+ */
+#define SNAPSHOT_SWITCHES_SHIFT	0
+#define SNAPSHOT_BUTTONS_SHIFT	8
+#define SNAPSHOT_SENSORS_SHIFT	16
+
+/**
+ * A hardware backend
+ */
+typedef struct {
+	const char *name;                         /**< Name used to select the backend */
+	int (*setUp)(void);                       /**< Sets up the backend */
+	int (*tearDown)(void);                    /**< Tears down the backend */
+	UINT8 (*readSwitches)(void);              /**< Reads all switches */
+	UINT8 (*readButtons)(void);               /**< Reads all buttons */
+	UINT8 (*readButtonEdges)(void);           /**< Reads and clears the latched button edges (optional) */
+	UINT8 (*readSensors)(void);               /**< Reads all sensors */
+	void (*writeLeds)(UINT8 pattern);         /**< Sets all LEDs (and blanks the 7-segment display) */
+	void (*writeDigit)(int digit, UINT8 segments); /**< Shows a digit of the 7-segment display (optional) */
+	void (*writeActuators)(UINT8 actuators);  /**< Sets all actuators */
+} HardwareBackend;
+
 /**
  * Global pointer to memory mapping base address
  */
 extern void *mmap_base;
 
+/**
+ * Selects the hardware backend
+ *
+ * Has to be called before the hardware controller is set up.
+ *
+ * @param name Name of the backend ("board", "sim" or "gpiochip")
+ * @return Returns TRUE if the backend exists
+ */
+extern int selectHardwareBackend(const char *name);
+
 /**
  * Initializes the hardware controller
  *
@@ -35,4 +88,75 @@ extern int tearDownHardwareController(void);
  */
 extern int getHardwareSetUpState(void);
 
+/**
+ * Read the states of all switches, buttons and sensors at once
+ *
+ * Inputs that are shared (e.g. the sensors connected to the switch inputs
+ * of the board) are read only once.
+ *
+ * If the backend latches edges in hardware, the buttons which had an edge
+ * since the last read are reported as well, so a press between two reads
+ * is not lost.
+ *
+ * @param edges Is set to the lines with a latched edge
+ * @return Returns the states of all inputs
+ */
+extern InputSnapshot readInputs(InputSnapshot *edges);
+
+/**
+ * Set all LEDs
+ *
+ * May be called from any thread.
+ *
+ * @param pattern One bit per LED (LED_1, ...)
+ */
+extern void writeLeds(UINT8 pattern);
+
+/**
+ * Share the port of the LEDs with the 7-segment display
+ *
+ * While the port is shared, writeLeds() only keeps the pattern and the
+ * thread which multiplexes the digits shows the LEDs in a time slot of
+ * their own with showLeds(). When the sharing ends, the LEDs are shown
+ * again.
+ *
+ * @param isShared TRUE while the digits are multiplexed
+ */
+extern void shareLedPort(int isShared);
+
+/**
+ * Show the LEDs in their time slot of the multiplex
+ *
+ * Blanks the digits and writes the last LED pattern. May be called from
+ * any thread.
+ */
+extern void showLeds(void);
+
+/**
+ * Check if the board has a 7-segment display
+ *
+ * @return Returns TRUE if writeDigit() can be used
+ */
+extern int hasSegmentDisplay(void);
+
+/**
+ * Show a digit of the 7-segment display
+ *
+ * Only one digit is shown at a time, so the digits have to be multiplexed
+ * (see segmentDisplay.h). May be called from any thread.
+ *
+ * @param digit The digit (0 is the leftmost one)
+ * @param segments One bit per segment (bit 0 is segment a, bit 7 the dot)
+ */
+extern void writeDigit(int digit, UINT8 segments);
+
+/**
+ * Set all actuators
+ *
+ * May be called from any thread.
+ *
+ * @param actuators One bit per actuator (ACTUATOR_COFFEE, ...)
+ */
+extern void writeActuators(UINT8 actuators);
+
 #endif /* HARDWARECONTROLLER_H_ */
@@ -11,22 +11,195 @@
 #include "types.h"
 #include "hardwareController.h"
 #include "inputController.h"
+#include "watchdog.h"
+#include "loopStatistics.h"
 
-#ifdef CARME
- #include "carme.h"
-#elif defined(ORCHID)
- #include "orchid.h"
-#else
- #error "no board defined!"
-#endif
+/**
+ * Number of input lines in a snapshot
+ */
+#define NUM_OF_INPUT_LINES	24
+
+/**
+ * Default settle times: The slide switches bounce longer than the buttons.
+ * An empty tank has to stop the delivery at once (the sensors are polled
+ * at 1 kHz while producing), so the sensors are only settled a few reads.
+ */
+#define SWITCH_SETTLE_TIME	MILLISECONDS(50)
+#define BUTTON_SETTLE_TIME	MILLISECONDS(20)
+#define SENSOR_SETTLE_TIME	MILLISECONDS(3)
+
+/**
+ * Hold times of a button until the long press and the repeat events
+ */
+#define LONG_PRESS_TIME		MILLISECONDS(1000)
+#define REPEAT_INTERVAL		MILLISECONDS(250)
+
+/**
+ * Lines of the buttons, only they have long press and repeat events
+ */
+#define BUTTON_LINES		((InputSnapshot) 0xff << SNAPSHOT_BUTTONS_SHIFT)
+
+/**
+ * Size of the input event queue (a power of two)
+ */
+#define INPUT_QUEUE_SIZE	32
+
+/**
+ * Debouncing state of an input line
+ */
+typedef struct {
+	TIME settleTime;       /**< How long the line has to be stable */
+	TIME changeTime;       /**< When the raw state changed last */
+	TIME acceptTime;       /**< When a change was taken over last */
+	TIME nextHoldTime;     /**< When the next long press or repeat is due */
+} InputLine;
 
 static int isInputControllerSetUp = FALSE;
+static InputLine lines[NUM_OF_INPUT_LINES];
+static InputSnapshot rawSnapshot = 0;
+static InputSnapshot snapshot = 0;
+static InputSnapshot longPressed = 0;
+static TIME lastReadTime = 0;
+
+// Queue of the detected events and the batch of the current tick
+static QueuedInputEvent queue[INPUT_QUEUE_SIZE];
+static unsigned int queueHead = 0;
+static unsigned int queueTail = 0;
+static UINT32 droppedEvents = 0;
+static QueuedInputEvent batch[INPUT_QUEUE_SIZE];
+static int batchSize = 0;
+
+/**
+ * Appends an event to the queue, drops it if the queue is full
+ */
+static void queueInputEvent(InputSnapshot line, enum InputEvent event, TIME time)
+{
+	if (queueTail - queueHead == INPUT_QUEUE_SIZE) {
+		droppedEvents++;
+		return;
+	}
+	queue[queueTail % INPUT_QUEUE_SIZE] = (QueuedInputEvent) { line, event, time };
+	queueTail++;
+}
+
+/**
+ * Moves all queued events into the batch of the current tick
+ */
+static void drainInputEvents(TIME now)
+{
+	batchSize = 0;
+	while (queueHead != queueTail) {
+		QueuedInputEvent *event = &queue[queueHead % INPUT_QUEUE_SIZE];
+
+		// the events are handled in this tick:
+		recordLoopStatistic(loopStatistic_actionLatency, now - event->time);
+		batch[batchSize++] = *event;
+		queueHead++;
+	}
+}
+
+/**
+ * Sets the settle time of all lines in a mask
+ */
+static void setSettleTime(InputSnapshot mask, TIME settleTime)
+{
+	for (int i = 0; i < NUM_OF_INPUT_LINES; i++) {
+		if (mask & ((InputSnapshot) 1 << i)) {
+			lines[i].settleTime = settleTime;
+		}
+	}
+}
+
+/**
+ * Takes over the raw states which are stable for their settle time and
+ * queues the detected events
+ *
+ * The lines with a latched edge, which are back in their settled state,
+ * were pressed and released between two reads. This is only taken as a
+ * short press if the reads are further apart than the settle time.
+ */
+static void debounce(InputSnapshot raw, InputSnapshot edges, TIME now)
+{
+	InputSnapshot bits;
+
+	// restart the settle time of the lines that changed:
+	for (bits = raw ^ rawSnapshot; bits; bits &= bits - 1) {
+		lines[__builtin_ctzl(bits)].changeTime = now;
+	}
+	rawSnapshot = raw;
+
+	// take over the settled changes:
+	for (bits = raw ^ snapshot; bits; bits &= bits - 1) {
+		int line = __builtin_ctzl(bits);
+		InputSnapshot mask = (InputSnapshot) 1 << line;
+
+		if (now - lines[line].changeTime < lines[line].settleTime) {
+			continue;
+		}
+		// the event is stamped with the time the change was sampled first:
+		lines[line].acceptTime = now;
+		snapshot ^= mask;
+		if (snapshot & mask) {
+			queueInputEvent(mask, inputEvent_press, lines[line].changeTime);
+			lines[line].nextHoldTime = now + LONG_PRESS_TIME;
+		} else {
+			queueInputEvent(mask, inputEvent_release, lines[line].changeTime);
+			longPressed &= ~mask;
+		}
+	}
+
+	// the edges of settled lines are short presses, the others are
+	// bouncing or seen as a change anyway:
+	for (bits = edges & ~(raw ^ snapshot); bits; bits &= bits - 1) {
+		int line = __builtin_ctzl(bits);
+		InputSnapshot mask = (InputSnapshot) 1 << line;
+
+		if (now - lines[line].acceptTime < lines[line].settleTime) {
+			continue;
+		}
+		// if the reads are close enough, a change between them was too
+		// short (it would have been seen as a change otherwise):
+		if (now - lastReadTime < lines[line].settleTime) {
+			continue;
+		}
+		lines[line].acceptTime = now;
+		if (snapshot & mask) {
+			queueInputEvent(mask, inputEvent_release, now);
+			queueInputEvent(mask, inputEvent_press, now);
+			lines[line].nextHoldTime = now + LONG_PRESS_TIME;
+			longPressed &= ~mask;
+		} else {
+			queueInputEvent(mask, inputEvent_press, now);
+			queueInputEvent(mask, inputEvent_release, now);
+		}
+	}
+
+	// the first hold event of a button is the long press, then it repeats:
+	for (bits = snapshot & BUTTON_LINES; bits; bits &= bits - 1) {
+		int line = __builtin_ctzl(bits);
+		InputSnapshot mask = (InputSnapshot) 1 << line;
+
+		if (now < lines[line].nextHoldTime) {
+			continue;
+		}
+		if (longPressed & mask) {
+			queueInputEvent(mask, inputEvent_repeat, now);
+		} else {
+			queueInputEvent(mask, inputEvent_longPress, now);
+			longPressed |= mask;
+		}
+		lines[line].nextHoldTime = now + REPEAT_INTERVAL;
+	}
+	lastReadTime = now;
+}
 
 /**
  * @copydoc setUpInputController
  */
 int setUpInputController(void)
 {
+	InputSnapshot edges;
+
 	// check if input controller is already set up:
 	if (isInputControllerSetUp) {
 		return FALSE;
@@ -38,6 +211,21 @@ int setUpInputController(void)
 			return FALSE;
 		}
 	}
+	setSettleTime((InputSnapshot) 0xff << SNAPSHOT_SWITCHES_SHIFT, SWITCH_SETTLE_TIME);
+	setSettleTime((InputSnapshot) 0xff << SNAPSHOT_BUTTONS_SHIFT, BUTTON_SETTLE_TIME);
+	setSettleTime((InputSnapshot) 0xff << SNAPSHOT_SENSORS_SHIFT, SENSOR_SETTLE_TIME);
+
+	// the states at startup are taken over without events:
+	rawSnapshot = snapshot = readInputs(&edges);
+	longPressed = 0;
+	queueHead = queueTail = 0;
+	batchSize = 0;
+	for (int i = 0; i < NUM_OF_INPUT_LINES; i++) {
+		lines[i].changeTime = getCurrentTime();
+		lines[i].acceptTime = 0;
+	}
+	lastReadTime = getCurrentTime();
+
 	isInputControllerSetUp = TRUE;
 	return TRUE;
 }
@@ -51,10 +239,46 @@ int tearDownInputController(void)
 	if (!isInputControllerSetUp) {
 		return FALSE;
 	}
+#ifdef DEBUG
+	if (droppedEvents) {
+		printf("Input events dropped: %lu\n", droppedEvents);
+	}
+#endif
 	isInputControllerSetUp = FALSE;
 	return TRUE;
 }
 
+/**
+ * @copydoc takeInputSnapshot
+ */
+int takeInputSnapshot(void)
+{
+	InputSnapshot raw, edges;
+	InputSnapshot lastSnapshot = snapshot;
+
+	if (!isInputControllerSetUp) {
+		return FALSE;
+	}
+
+	// the buttons may be read over GPIO files (CARME board), which could
+	// block:
+	enum WatchdogPhase phase = setWatchdogPhase(watchdogPhase_inputs);
+	raw = readInputs(&edges);
+	debounce(raw, edges, getCurrentTime());
+	setWatchdogPhase(phase);
+
+	drainInputEvents(getCurrentTime());
+	return snapshot != lastSnapshot || batchSize > 0;
+}
+
+/**
+ * @copydoc getInputSnapshot
+ */
+InputSnapshot getInputSnapshot(void)
+{
+	return snapshot;
+}
+
 /**
  * @copydoc getSwitchState
  */
@@ -66,14 +290,7 @@ enum SwitchState getSwitchState(int id)
 		return switch_unknown;
 	}
 
-#ifdef CARME
-	switches = *(volatile unsigned char *) (mmap_base + SWITCH_OFFSET);
-#elif defined(ORCHID)
-	// it is important to read twice, else the result would not be reliable
-	// (usleep for some microseconds would work as well):
-	GPIO_read_switch();
-    switches = GPIO_read_switch();
-#endif
+	switches = (UINT8) (snapshot >> SNAPSHOT_SWITCHES_SHIFT);
 
     // mask value of all switches with switch id to get only the status of the
     // selected switch:
@@ -95,20 +312,7 @@ enum ButtonState getButtonState(int id)
 		return button_unknown;
 	}
 
-#ifdef CARME
-	// on CARME board we read each single button state directly over GPIO
-	button = (UINT8) readGPIOButton(id);
-	if (button == 1) {
-		return button_on;
-	} else {
-		return button_off;
-	}
-#elif defined(ORCHID)
-	// on ORCHID board we get the states of all buttons.
-	// It is important to read twice, else the result would not be reliable
-	// (usleep for some microseconds would work as well)
-	GPIO_read_button();
-	button = GPIO_read_button();
+	button = (UINT8) (snapshot >> SNAPSHOT_BUTTONS_SHIFT);
 
     // mask value of all buttons with button id to get only the status of the
 	// selected button
@@ -117,5 +321,29 @@ enum ButtonState getButtonState(int id)
     } else {
     	return button_off;
     }
-#endif
+}
+
+/**
+ * @copydoc getInputEvents
+ */
+int getInputEvents(const QueuedInputEvent **events)
+{
+	*events = batch;
+	return batchSize;
+}
+
+/**
+ * @copydoc setSwitchSettleTime
+ */
+void setSwitchSettleTime(int id, TIME settleTime)
+{
+	setSettleTime((InputSnapshot) id << SNAPSHOT_SWITCHES_SHIFT, settleTime);
+}
+
+/**
+ * @copydoc setButtonSettleTime
+ */
+void setButtonSettleTime(int id, TIME settleTime)
+{
+	setSettleTime((InputSnapshot) id << SNAPSHOT_BUTTONS_SHIFT, settleTime);
 }
@@ -1,5 +1,15 @@
 /**
  * @brief   Initialize and read buttons and switches
+ *
+ * The inputs are sampled once per tick and debounced: A change of an input
+ * is taken over when the input was stable for its settle time. On the
+ * debounced states the input events (press, release, long press and
+ * repeat) are detected. They are queued with a timestamp and handed over
+ * in one batch per tick to the active view and the business logic.
+ *
+ * Switches and sensors are states, so their levels are checked with
+ * getSwitchState() and getSensorState() as well.
+ *
  * @file    inputController.h
  * @version 1.0
  * @author  Elmar Vonlanthen (vonle1@bfh.ch)
@@ -9,6 +19,9 @@
 #ifndef INPUTCONTROLLER_H_
 #define INPUTCONTROLLER_H_
 
+#include "hardwareController.h"
+#include "timebase.h"
+
 #ifdef CARME
   /* Define switches */
   #define SWITCH_1		(1 << 0)
@@ -20,10 +33,10 @@
   #define SWITCH_7		(1 << 6)
   #define SWITCH_8		(1 << 7)
   /* Define buttons */
-  #define BUTTON_1		 99
-  #define BUTTON_2		101
-  #define BUTTON_3		102
-  #define BUTTON_4		103
+  #define BUTTON_1		(1 << 0)
+  #define BUTTON_2		(1 << 1)
+  #define BUTTON_3		(1 << 2)
+  #define BUTTON_4		(1 << 3)
 #elif defined(ORCHID)
   /* Define switches */
   #define SWITCH_1		(1 << 0)
@@ -55,6 +68,33 @@ enum ButtonState {
   button_unknown  /**< button_unknown */
 };
 
+/**
+ * Predefined input events
+ */
+enum InputEvent {
+  inputEvent_press = 0, /**< input switched on                        */
+  inputEvent_release,   /**< input switched off                       */
+  inputEvent_longPress, /**< button held for LONG_PRESS_TIME          */
+  inputEvent_repeat,    /**< button still held, every REPEAT_INTERVAL */
+  NUM_OF_INPUT_EVENTS
+};
+
+/**
+ * Lines of the inputs in an input snapshot
+ */
+#define SWITCH_LINE(id)		((InputSnapshot) (id) << SNAPSHOT_SWITCHES_SHIFT)
+#define BUTTON_LINE(id)		((InputSnapshot) (id) << SNAPSHOT_BUTTONS_SHIFT)
+#define SENSOR_LINE(id)		((InputSnapshot) (id) << SNAPSHOT_SENSORS_SHIFT)
+
+/**
+ * A queued input event
+ */
+typedef struct {
+	InputSnapshot line;    /**< Line of the input (SWITCH_LINE(SWITCH_1), ...) */
+	enum InputEvent event; /**< What happened */
+	TIME time;             /**< When the change was sampled first */
+} QueuedInputEvent;
+
 /**
  * Initializes the input controller
  *
@@ -69,6 +109,25 @@ extern int setUpInputController(void);
  */
 extern int tearDownInputController(void);
 
+/**
+ * Samples all switches, buttons and sensors
+ *
+ * Is called once per tick, before the user interface and the business
+ * logic run, so they all see the same states during a tick. The queued
+ * input events become the batch of the tick.
+ *
+ * @return Returns TRUE if a debounced state changed or the batch contains
+ * input events
+ */
+extern int takeInputSnapshot(void);
+
+/**
+ * Gets the debounced states sampled by the last takeInputSnapshot()
+ *
+ * @return The states of all inputs
+ */
+extern InputSnapshot getInputSnapshot(void);
+
 /**
  * Checks a switch of its state
  *
@@ -85,4 +144,32 @@ extern enum SwitchState getSwitchState(int id);
  */
 extern enum ButtonState getButtonState(int id);
 
+/**
+ * Gets the input events of the current tick
+ *
+ * @param events Is set to the first event of the batch
+ * @return Number of events in the batch
+ */
+extern int getInputEvents(const QueuedInputEvent **events);
+
+/**
+ * Sets how long a switch has to be stable until a change is taken over
+ *
+ * Has to be called after the input controller is set up.
+ *
+ * @param id Id of switch
+ * @param settleTime The settle time
+ */
+extern void setSwitchSettleTime(int id, TIME settleTime);
+
+/**
+ * Sets how long a button has to be stable until a change is taken over
+ *
+ * Has to be called after the input controller is set up.
+ *
+ * @param id Id of button
+ * @param settleTime The settle time
+ */
+extern void setButtonSettleTime(int id, TIME settleTime);
+
 #endif /* INPUTCONTROLLER_H_ */
@@ -7,33 +7,271 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
 
 #include "defines.h"
 #include "types.h"
-#include "timer.h"
+#include "eventLoop.h"
 #include "hardwareController.h"
 #include "ledController.h"
 
-#ifdef CARME
- #include "carme.h"
-#elif defined(ORCHID)
- #include "orchid.h"
-#else
- #error "no board defined!"
-#endif
-
 typedef struct {
 	int id;
 	int state;
-	int durationOn;
-	int durationOff;
-	int blinkingState;
-	TIMER timer;
+	TIME durationOn;
+	TIME durationOff;
+	TIME phase;
+	UINT8 brightness;
+	UINT8 fadeBrightness;
+	TIME fadeStart;
+	TIME fadeDuration;
 } LedDescriptor;
 
 static LedDescriptor leds[NUM_OF_LEDS];
 static int isLedControllerSetUp = FALSE;
 
+// LEDs covered by an overlay (e.g. an animation) and their pattern
+static UINT8 overlayLeds = 0;
+static UINT8 overlayPattern = 0;
+
+/**
+ * Interval of the brightness updates while a LED is fading
+ */
+#define FADE_STEP MILLISECONDS(20)
+
+/**
+ * Maximum number of output patterns in a PWM period (one per LED and
+ * the pattern at the start of the period)
+ */
+#define MAX_PWM_EDGES (NUM_OF_LEDS + 1)
+
+/**
+ * An output pattern of a PWM period
+ */
+typedef struct {
+	TIME offset;   /**< Time since the start of the period */
+	UINT8 pattern; /**< LEDs which are on from then on */
+} PwmEdge;
+
+// Shadow of the pattern on the hardware and the write counters (protected
+// by the mutex, as the PWM thread writes the LEDs as well)
+static pthread_mutex_t ledMutex = PTHREAD_MUTEX_INITIALIZER;
+static UINT8 committedStates = 0;
+static int isCommittedStateKnown = FALSE;
+static unsigned long committedWrites = 0;
+static unsigned long skippedWrites = 0;
+
+// Duty cycles of all LEDs handed to the PWM thread (protected by the mutex)
+static pthread_cond_t dutiesChanged = PTHREAD_COND_INITIALIZER;
+static UINT8 duties[NUM_OF_LEDS];
+static UINT32 dutiesGeneration = 0;
+static int isAnyLedDimmed = FALSE;
+
+static unsigned int pwmFrequency = LED_PWM_FREQUENCY;
+static pthread_t pwmThread;
+static volatile int isPwmRunning = FALSE;
+
+// PWM statistics, written by the PWM thread
+static unsigned long pwmPeriods = 0;
+static unsigned long pwmEdges = 0;
+static unsigned long pwmOverruns = 0;
+static TIME pwmLatencySum = 0;
+static TIME pwmLatencyMax = 0;
+static TIME pwmActiveTime = 0;
+static TIME pwmCpuTime = 0;
+
+/**
+ * Write the LED pattern to the hardware if it differs from the shadow
+ *
+ * @param newStates The LED pattern
+ */
+static void commitLeds(UINT8 newStates)
+{
+	if (isCommittedStateKnown && newStates == committedStates) {
+		skippedWrites++;
+		return;
+	}
+	writeLeds(newStates);
+	committedStates = newStates;
+	isCommittedStateKnown = TRUE;
+	committedWrites++;
+}
+
+/**
+ * Reads the monotonic clock
+ */
+static TIME readClock(clockid_t clock)
+{
+	struct timespec ts;
+
+	clock_gettime(clock, &ts);
+	return SECONDS(ts.tv_sec) + NANOSECONDS(ts.tv_nsec);
+}
+
+/**
+ * Compute the output patterns of a PWM period in one pass
+ *
+ * All LEDs with a duty cycle are switched on at the start of the period.
+ * Each LED is switched off after its share of the period, LEDs with the
+ * same duty cycle share an edge.
+ *
+ * @param periodDuties The duty cycles of all LEDs
+ * @param period The length of the period
+ * @param edges Is set to the output patterns ordered by time
+ * @return Returns the number of output patterns
+ */
+static int computePwmEdges(const UINT8 *periodDuties, TIME period, PwmEdge *edges)
+{
+	UINT8 offDuties[NUM_OF_LEDS];
+	UINT8 offPatterns[NUM_OF_LEDS];
+	int numberOfOffEdges = 0;
+	UINT8 pattern = 0;
+
+	// insert the LEDs which are switched off in the period by duty cycle:
+	for (int i = 0; i < NUM_OF_LEDS; i++) {
+		UINT8 duty = periodDuties[i];
+		int j = 0;
+
+		if (duty == 0) {
+			continue;
+		}
+		pattern |= LED_ID(i+1);
+		if (duty == LED_FULL_BRIGHTNESS) {
+			continue;
+		}
+		while (j < numberOfOffEdges && offDuties[j] < duty) {
+			j++;
+		}
+		if (j == numberOfOffEdges || offDuties[j] != duty) {
+			memmove(&offDuties[j+1], &offDuties[j], numberOfOffEdges - j);
+			memmove(&offPatterns[j+1], &offPatterns[j], numberOfOffEdges - j);
+			offDuties[j] = duty;
+			offPatterns[j] = 0;
+			numberOfOffEdges++;
+		}
+		offPatterns[j] |= LED_ID(i+1);
+	}
+
+	edges[0].offset = 0;
+	edges[0].pattern = pattern;
+	for (int j = 0; j < numberOfOffEdges; j++) {
+		pattern &= ~offPatterns[j];
+		edges[j+1].offset = period * offDuties[j] / LED_FULL_BRIGHTNESS;
+		edges[j+1].pattern = pattern;
+	}
+	return numberOfOffEdges + 1;
+}
+
+/**
+ * The PWM thread
+ *
+ * Sleeps while no LED is dimmed. Otherwise it computes the output patterns
+ * of each period from the current duty cycles and writes them at their
+ * time. If the duty cycles change, the rest of the period is dropped.
+ */
+static void * runLedPwm(void *argument)
+{
+	TIME period = SECONDS(1) / pwmFrequency;
+	TIME cpuStart = readClock(CLOCK_THREAD_CPUTIME_ID);
+	TIME periodStart = 0;
+	TIME activeStart = 0;
+	int isActive = FALSE;
+
+	pthread_mutex_lock(&ledMutex);
+	while (isPwmRunning) {
+		if (!isAnyLedDimmed) {
+			if (isActive) {
+				pwmActiveTime += readClock(CLOCK_MONOTONIC) - activeStart;
+				isActive = FALSE;
+			}
+			pthread_cond_wait(&dutiesChanged, &ledMutex);
+			continue;
+		}
+		if (!isActive) {
+			periodStart = activeStart = readClock(CLOCK_MONOTONIC);
+			isActive = TRUE;
+		}
+
+		UINT8 periodDuties[NUM_OF_LEDS];
+		UINT32 generation = dutiesGeneration;
+		memcpy(periodDuties, duties, sizeof(periodDuties));
+		pthread_mutex_unlock(&ledMutex);
+
+		PwmEdge edges[MAX_PWM_EDGES];
+		int numberOfEdges = computePwmEdges(periodDuties, period, edges);
+
+		pthread_mutex_lock(&ledMutex);
+		for (int i = 0; i < numberOfEdges && generation == dutiesGeneration; i++) {
+			TIME edgeTime = periodStart + edges[i].offset;
+			struct timespec wakeUpTime = {
+				.tv_sec = edgeTime / SECONDS(1),
+				.tv_nsec = edgeTime % SECONDS(1)
+			};
+
+			pthread_mutex_unlock(&ledMutex);
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeUpTime, NULL);
+			TIME latency = readClock(CLOCK_MONOTONIC) - edgeTime;
+			pthread_mutex_lock(&ledMutex);
+
+			// the duty cycles may have changed while sleeping:
+			if (generation != dutiesGeneration || !isPwmRunning) {
+				break;
+			}
+			commitLeds(edges[i].pattern);
+			pwmEdges++;
+			pwmLatencySum += latency;
+			if (latency > pwmLatencyMax) {
+				pwmLatencyMax = latency;
+			}
+		}
+		pwmPeriods++;
+
+		// skip the periods which were missed:
+		periodStart += period;
+		TIME now = readClock(CLOCK_MONOTONIC);
+		if (now > periodStart + period) {
+			pwmOverruns += (now - periodStart) / period;
+			periodStart += (now - periodStart) / period * period;
+		}
+	}
+	if (isActive) {
+		pwmActiveTime += readClock(CLOCK_MONOTONIC) - activeStart;
+	}
+	pthread_mutex_unlock(&ledMutex);
+
+	pwmCpuTime = readClock(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+	return NULL;
+}
+
+/**
+ * Get the current brightness of a LED
+ *
+ * @param led Pointer to LED descriptor structure
+ * @param now The current time
+ * @return Returns the brightness, which is interpolated while fading
+ */
+static UINT8 getBrightness(LedDescriptor *led, TIME now)
+{
+	if (now >= led->fadeStart + led->fadeDuration) {
+		return led->brightness;
+	}
+	TIME elapsed = now - led->fadeStart;
+	int difference = (int) led->brightness - (int) led->fadeBrightness;
+
+	return led->fadeBrightness + difference * (long long) elapsed / (long long) led->fadeDuration;
+}
+
+/**
+ * Update the LEDs when the event loop wakes up for a toggle
+ */
+static void updateBlinkingLeds(void)
+{
+	updateAllLeds();
+}
+
 /**
  * @copydoc setUpLedController
  */
@@ -56,13 +294,33 @@ int setUpLedController(void)
 		id = LED_ID(i+1);
 		leds[i].id = id;
 		leds[i].state = led_off;
-		leds[i].durationOn = 1000;
-		leds[i].durationOff = 1000;
-		leds[i].blinkingState = led_off;
-		leds[i].timer = NULL;
+		leds[i].durationOn = MILLISECONDS(1000);
+		leds[i].durationOff = MILLISECONDS(1000);
+		leds[i].phase = 0;
+		leds[i].brightness = LED_FULL_BRIGHTNESS;
+		leds[i].fadeStart = 0;
+		leds[i].fadeDuration = 0;
+		duties[i] = 0;
 	}
-	updateAllLeds();
+	overlayLeds = overlayPattern = 0;
+	// the state of the hardware is unknown, so the first pattern is written:
+	isCommittedStateKnown = FALSE;
+	committedWrites = skippedWrites = 0;
+	isAnyLedDimmed = FALSE;
+	pwmPeriods = pwmEdges = pwmOverruns = 0;
+	pwmLatencySum = pwmLatencyMax = pwmActiveTime = pwmCpuTime = 0;
 	isLedControllerSetUp = TRUE;
+	updateAllLeds();
+	addWakeUpSource(&getNextLedToggleTime, &updateBlinkingLeds);
+
+	// without the PWM thread, dimmed LEDs are fully on:
+	if (pwmFrequency) {
+		isPwmRunning = TRUE;
+		if (pthread_create(&pwmThread, NULL, &runLedPwm, NULL) != 0) {
+			perror("pthread_create()");
+			isPwmRunning = FALSE;
+		}
+	}
 	return TRUE;
 }
 
@@ -71,48 +329,67 @@ int setUpLedController(void)
  */
 int tearDownLedController(void)
 {
-	int id;
 	for (int i = 0; i < NUM_OF_LEDS; i++) {
-		id = LED_ID(i+1);
 		leds[i].state = led_off;
 		leds[i].durationOn = 0;
 		leds[i].durationOff = 0;
-		leds[i].blinkingState = led_off;
-		abortTimer(leds[i].timer);
-		leds[i].timer = NULL;
+	}
+	removeWakeUpSource(&getNextLedToggleTime);
+	if (isPwmRunning) {
+		pthread_mutex_lock(&ledMutex);
+		isPwmRunning = FALSE;
+		pthread_cond_signal(&dutiesChanged);
+		pthread_mutex_unlock(&ledMutex);
+		pthread_join(pwmThread, NULL);
+
+#ifdef DEBUG
+		printf("LED PWM: %u Hz, %lu periods, %lu edges, %lu overruns\n",
+				pwmFrequency, pwmPeriods, pwmEdges, pwmOverruns);
+		if (pwmEdges) {
+			printf("LED PWM: edge latency avg %llu us, max %llu us, CPU %llu us per active second\n",
+					pwmLatencySum / pwmEdges / MICROSECONDS(1), pwmLatencyMax / MICROSECONDS(1),
+					pwmActiveTime ? pwmCpuTime * SECONDS(1) / pwmActiveTime / MICROSECONDS(1) : 0);
+		}
+#endif
 	}
 	updateAllLeds();
+#ifdef DEBUG
+	printf("LEDs: %lu patterns written, %lu unchanged skipped\n", committedWrites, skippedWrites);
+#endif
 	isLedControllerSetUp = FALSE;
 	return TRUE;
 }
 
 /**
- * Update specified led if its state is set to blinking
+ * Get the position of a blinking LED within its period
  *
- * The functions sets a timer for each status interval (off/on) an switches
- * its state, if the timer is elapsed.
+ * @param led Pointer to LED descriptor structure
+ * @param now The current time
+ * @return Returns the time since the LED was switched on last
+ */
+static TIME getBlinkingPosition(LedDescriptor *led, TIME now)
+{
+	TIME period = led->durationOn + led->durationOff;
+
+	return (now + period - led->phase % period) % period;
+}
+
+/**
+ * Check if a blinking LED is on
  *
  * @param led Pointer to LED descriptor structure
- * @return Returns TRUE if update was successful
+ * @param now The current time
+ * @return Returns TRUE if the LED is in the on part of its period
  */
-static int updateBlinkingState(LedDescriptor *led)
+static int isBlinkingLedOn(LedDescriptor *led, TIME now)
 {
-	if (!isLedControllerSetUp) {
-		return FALSE;
+	if (led->durationOff == 0) {
+		return TRUE;
 	}
-	// check if current timer is elapsed:
-	if (led->timer == NULL || isTimerElapsed(led->timer)) {
-		// state was led on, set new timer for duration led off:
-		if (led->blinkingState == led_on) {
-			led->blinkingState = led_off;
-			led->timer = setUpTimer(led->durationOff);
-		// state was led off, set new timer for duration led on:
-		} else {
-			led->blinkingState = led_on;
-			led->timer = setUpTimer(led->durationOn);
-		}
+	if (led->durationOn == 0) {
+		return FALSE;
 	}
-	return TRUE;
+	return getBlinkingPosition(led, now) < led->durationOn;
 }
 
 /**
@@ -123,35 +400,51 @@ int updateAllLeds() {
 		return FALSE;
 	}
 	UINT8 newStates = 0;
+	UINT8 newDuties[NUM_OF_LEDS];
+	int isDimmed = FALSE;
 	int ret = TRUE;
-	LedDescriptor *led;
+	TIME now = getCurrentTime();
 
 	// Read all values from leds structure and set the leds according to the
 	// configured state. Link the state of each value with the variable
 	// newStates ('OR operation') and update all leds at once
 	for (int i = 0; i < NUM_OF_LEDS; i++) {
+		newDuties[i] = 0;
 
-		if (leds[i].state == led_on) {
+		if (leds[i].state == led_on
+				// blinking leds are on in the first part of their period:
+				|| (leds[i].state == led_blinking && isBlinkingLedOn(&leds[i], now))) {
+			newDuties[i] = getBrightness(&leds[i], now);
+		}
+		// covered leds show the overlay:
+		if (overlayLeds & leds[i].id) {
+			newDuties[i] = (overlayPattern & leds[i].id) ? LED_FULL_BRIGHTNESS : 0;
+		}
+		// without the PWM thread, every lit led is fully on:
+		if (newDuties[i] && !isPwmRunning) {
+			newDuties[i] = LED_FULL_BRIGHTNESS;
+		}
+		if (newDuties[i]) {
 			newStates |= leds[i].id;
-		// update blinking states an get new states:
-		} else if (leds[i].state == led_blinking) {
-			led = &leds[i];
-			// if the state is 'blinking' we let the function updateBlinkingState
-			// decide if the led has to be on or off. The state is stored in the
-			// structure value 'blinkingState'
-			updateBlinkingState(led);
-			if (leds[i].blinkingState == led_on) {
-				newStates |= leds[i].id;
-			}
+		}
+		if (newDuties[i] && newDuties[i] != LED_FULL_BRIGHTNESS) {
+			isDimmed = TRUE;
 		}
 	}
 
-	// Now update the LEDs:
-	#ifdef CARME
-		*(volatile unsigned char *) (mmap_base + LED_OFFSET) = newStates;
-	#elif defined(ORCHID)
-		GPIO_write_led(newStates);
-	#endif
+	pthread_mutex_lock(&ledMutex);
+	// hand changed duty cycles over to the PWM thread:
+	if (memcmp(newDuties, duties, sizeof(duties)) != 0) {
+		memcpy(duties, newDuties, sizeof(duties));
+		dutiesGeneration++;
+		isAnyLedDimmed = isDimmed;
+		pthread_cond_signal(&dutiesChanged);
+	}
+	// Now update the LEDs (if they changed), unless the PWM thread does it:
+	if (!isDimmed) {
+		commitLeds(newStates);
+	}
+	pthread_mutex_unlock(&ledMutex);
 	return ret;
 }
 
@@ -180,7 +473,7 @@ int updateLed(int id, enum LedState state)
 /**
  * @copydoc setBlinkingFreq
  */
-int setBlinkingFreq(int id, int durationOn, int durationOff)
+int setBlinkingFreq(int id, TIME durationOn, TIME durationOff)
 {
 	if (!isLedControllerSetUp) {
 		return FALSE;
@@ -188,12 +481,154 @@ int setBlinkingFreq(int id, int durationOn, int durationOff)
 	// change the blinking frequence for one led:
 	for (int i = 0; i < NUM_OF_LEDS; i++) {
 		if (leds[i].id == id) {
-			// duration in milliseconds while the led is on:
+			// duration while the led is on:
 			leds[i].durationOn = durationOn;
-			// duration in milliseconds while the led is off:
+			// duration while the led is off:
 			leds[i].durationOff = durationOff;
 			return TRUE;
 		}
 	}
 	return FALSE;
 }
+
+/**
+ * @copydoc getLedWriteCounts
+ */
+void getLedWriteCounts(unsigned long *committed, unsigned long *skipped)
+{
+	pthread_mutex_lock(&ledMutex);
+	*committed = committedWrites;
+	*skipped = skippedWrites;
+	pthread_mutex_unlock(&ledMutex);
+}
+
+/**
+ * @copydoc setBlinkingPhase
+ */
+int setBlinkingPhase(int id, TIME phase)
+{
+	if (!isLedControllerSetUp) {
+		return FALSE;
+	}
+	for (int i = 0; i < NUM_OF_LEDS; i++) {
+		if (leds[i].id == id) {
+			leds[i].phase = phase;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * @copydoc getNextLedToggleTime
+ */
+TIME getNextLedToggleTime(void)
+{
+	if (!isLedControllerSetUp) {
+		return NO_TIME;
+	}
+	TIME now = getCurrentTime();
+	TIME nextToggleTime = NO_TIME;
+
+	for (int i = 0; i < NUM_OF_LEDS; i++) {
+		LedDescriptor *led = &leds[i];
+
+		// fading leds are updated in steps:
+		if (led->state != led_off && now < led->fadeStart + led->fadeDuration) {
+			TIME fadeTime = now + FADE_STEP;
+
+			if (fadeTime > led->fadeStart + led->fadeDuration) {
+				fadeTime = led->fadeStart + led->fadeDuration;
+			}
+			if (fadeTime < nextToggleTime) {
+				nextToggleTime = fadeTime;
+			}
+		}
+		// leds which are always on or off don't toggle:
+		if (led->state != led_blinking || led->durationOn == 0 || led->durationOff == 0) {
+			continue;
+		}
+		TIME position = getBlinkingPosition(led, now);
+		TIME toggleTime = now - position
+				+ (position < led->durationOn ? led->durationOn : led->durationOn + led->durationOff);
+		if (toggleTime < nextToggleTime) {
+			nextToggleTime = toggleTime;
+		}
+	}
+	return nextToggleTime;
+}
+
+/**
+ * @copydoc setLedBrightness
+ */
+int setLedBrightness(int id, UINT8 brightness)
+{
+	return fadeLed(id, brightness, 0);
+}
+
+/**
+ * @copydoc fadeLed
+ */
+int fadeLed(int id, UINT8 brightness, TIME duration)
+{
+	if (!isLedControllerSetUp) {
+		return FALSE;
+	}
+	TIME now = getCurrentTime();
+
+	for (int i = 0; i < NUM_OF_LEDS; i++) {
+		if (leds[i].id == id) {
+			// a fade starts at the current (maybe interpolated) brightness:
+			leds[i].fadeBrightness = getBrightness(&leds[i], now);
+			leds[i].brightness = brightness;
+			leds[i].fadeStart = now;
+			leds[i].fadeDuration = duration;
+			updateAllLeds();
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * @copydoc setLedPwmFrequency
+ */
+int setLedPwmFrequency(unsigned int frequency)
+{
+	if (isLedControllerSetUp) {
+		return FALSE;
+	}
+	pwmFrequency = frequency;
+	return TRUE;
+}
+
+/**
+ * @copydoc setLedPwmPriority
+ */
+int setLedPwmPriority(int priority)
+{
+	struct sched_param schedulingParameters = { .sched_priority = priority };
+
+	if (!isPwmRunning) {
+		return FALSE;
+	}
+
+	if (pthread_setschedparam(pwmThread, SCHED_FIFO, &schedulingParameters) != 0) {
+		printf("Unable to set LED PWM priority!\n");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * @copydoc setLedOverlay
+ */
+int setLedOverlay(UINT8 coveredLeds, UINT8 pattern)
+{
+	if (!isLedControllerSetUp) {
+		return FALSE;
+	}
+	overlayLeds = coveredLeds;
+	overlayPattern = pattern;
+	return updateAllLeds();
+}
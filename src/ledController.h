@@ -1,5 +1,18 @@
 /**
  * @brief   Initializes and controls the LEDs
+ *
+ * The last pattern written to the hardware is kept in a shadow, so the
+ * hardware is only written if the pattern changes.
+ *
+ * Blinking LEDs don't have timers: Their level is computed from the
+ * current time, the on and off durations and a phase offset. So LEDs with
+ * the same durations and phase blink in sync, and the event loop only
+ * wakes up when a LED actually toggles.
+ *
+ * A lit LED can be dimmed: A PWM thread switches the dimmed LEDs on at the
+ * start of each period and off after their share of it. The thread only
+ * runs while a LED is dimmed, fully on and off LEDs are written directly.
+ *
  * @file    ledController.h
  * @version 1.0
  * @author  Elmar Vonlanthen (vonle1@bfh.ch)
@@ -9,6 +22,9 @@
 #ifndef LEDCONTROLLER_H_
 #define LEDCONTROLLER_H_
 
+#include "types.h"
+#include "timebase.h"
+
 /**
  * Define LED symbols
  */
@@ -36,6 +52,16 @@
 /* Get LED ID (e.g.: LED_ID(4) == LED_4) */
 #define		LED_ID(x) (1 << ((x)-1))
 
+/**
+ * Brightness of a LED which is fully on
+ */
+#define LED_FULL_BRIGHTNESS	255
+
+/**
+ * Default PWM frequency in Hz
+ */
+#define LED_PWM_FREQUENCY	200
+
 
 /**
  * Predefined LED states
@@ -82,12 +108,92 @@ extern int updateLed(int id, enum LedState state);
 /**
  * Set LED blinking interval
  *
- * Set the LED blinking interval values in milliseconds
+ * Set the LED blinking interval values
  *
  * @param id LED indentifier
  * @param durationOn Duration while LED is on
  * @param durationOff Duration while LED is off
  */
-extern int setBlinkingFreq(int id, int durationOn, int durationOff);
+extern int setBlinkingFreq(int id, TIME durationOn, TIME durationOff);
+
+/**
+ * Set LED blinking phase
+ *
+ * A blinking LED is switched on whenever the current time minus the phase
+ * is a multiple of the blinking period. The phase is 0 by default.
+ *
+ * @param id LED indentifier
+ * @param phase Phase offset
+ */
+extern int setBlinkingPhase(int id, TIME phase);
+
+/**
+ * Set LED brightness
+ *
+ * The brightness applies while the LED is on (or in the on part of its
+ * blinking period). It is LED_FULL_BRIGHTNESS by default.
+ *
+ * @param id LED indentifier
+ * @param brightness Brightness (0 to LED_FULL_BRIGHTNESS)
+ */
+extern int setLedBrightness(int id, UINT8 brightness);
+
+/**
+ * Fade LED brightness
+ *
+ * Changes the brightness linearly from the current brightness.
+ *
+ * @param id LED indentifier
+ * @param brightness Brightness at the end of the fade
+ * @param duration Duration of the fade
+ */
+extern int fadeLed(int id, UINT8 brightness, TIME duration);
+
+/**
+ * Cover LEDs with a pattern
+ *
+ * The covered LEDs show the pattern (fully on or off) instead of their own
+ * state, until they are no longer covered. Used by the LED sequencer.
+ *
+ * @param coveredLeds The covered LEDs
+ * @param pattern The LEDs which are on
+ * @return Returns TRUE if LED updating was successful
+ */
+extern int setLedOverlay(UINT8 coveredLeds, UINT8 pattern);
+
+/**
+ * Set the PWM frequency
+ *
+ * Has to be called before the LED controller is set up.
+ *
+ * @param frequency PWM frequency in Hz or 0 to show dimmed LEDs fully on
+ * @return Returns TRUE if successful
+ */
+extern int setLedPwmFrequency(unsigned int frequency);
+
+/**
+ * Set the SCHED_FIFO priority of the PWM thread
+ *
+ * @param priority The priority (1 to 99)
+ * @return Returns TRUE if successful
+ */
+extern int setLedPwmPriority(int priority);
+
+/**
+ * Get the next time a blinking LED toggles
+ *
+ * Fading LEDs are updated every few milliseconds as well.
+ *
+ * @return Returns the next toggle time or NO_TIME if no LED is blinking
+ */
+extern TIME getNextLedToggleTime(void);
+
+/**
+ * Get the LED write counters
+ *
+ * @param committed Is set to the number of patterns written to the hardware
+ * @param skipped Is set to the number of updates without a change
+ */
+extern void getLedWriteCounts(unsigned long *committed, unsigned long *skipped);
 
 #endif /* LEDCONTROLLER_H_ */
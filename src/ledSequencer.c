@@ -0,0 +1,169 @@
+/**
+ * @brief   Plays LED animations
+ * @version 1.0
+ * @file    ledSequencer.c
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#include "defines.h"
+#include "types.h"
+#include "eventLoop.h"
+#include "ledController.h"
+#include "ledSequencer.h"
+
+typedef struct {
+	const LedAnimation *animation; /**< The playing animation or NULL */
+	UINT8 leds;                    /**< LEDs covered by the animation */
+	int keyframe;                  /**< Index of the shown keyframe */
+	TIME keyframeEnd;              /**< End of the shown keyframe or NO_TIME if it is held */
+	TIME loopDuration;             /**< Duration of all keyframes */
+} LedLayer;
+
+static LedLayer layers[NUM_OF_LED_LAYERS];
+static int isLedSequencerSetUp = FALSE;
+
+/**
+ * Advance the animation of a layer to the keyframe shown at a time
+ *
+ * @param layer Pointer to the layer
+ * @param now The current time
+ */
+static void advanceKeyframes(LedLayer *layer, TIME now)
+{
+	const LedAnimation *animation = layer->animation;
+
+	// skip whole loops at once (e.g. after the time jumped forward):
+	if (animation->isLooping && layer->loopDuration
+			&& now >= layer->keyframeEnd + layer->loopDuration) {
+		layer->keyframeEnd += (now - layer->keyframeEnd) / layer->loopDuration * layer->loopDuration;
+	}
+	while (now >= layer->keyframeEnd) {
+		if (layer->keyframe + 1 < animation->numberOfKeyframes) {
+			layer->keyframe++;
+		} else if (animation->isLooping && layer->loopDuration) {
+			layer->keyframe = 0;
+		} else {
+			// hold the last keyframe:
+			layer->keyframeEnd = NO_TIME;
+			break;
+		}
+		layer->keyframeEnd += MILLISECONDS(animation->keyframes[layer->keyframe].duration);
+	}
+}
+
+/**
+ * Composite all layers and hand the result over to the LED controller
+ */
+static void updateLedSequencer(void)
+{
+	TIME now = getCurrentTime();
+	UINT8 coveredLeds = 0;
+	UINT8 pattern = 0;
+
+	// from the lowest to the highest layer:
+	for (int i = 0; i < NUM_OF_LED_LAYERS; i++) {
+		LedLayer *layer = &layers[i];
+
+		if (!layer->animation) {
+			continue;
+		}
+		advanceKeyframes(layer, now);
+		coveredLeds |= layer->leds;
+		pattern = (pattern & ~layer->leds)
+				| (layer->animation->keyframes[layer->keyframe].pattern & layer->leds);
+	}
+	setLedOverlay(coveredLeds, pattern);
+}
+
+/**
+ * @copydoc setUpLedSequencer
+ */
+int setUpLedSequencer(void)
+{
+	if (isLedSequencerSetUp) {
+		return FALSE;
+	}
+	for (int i = 0; i < NUM_OF_LED_LAYERS; i++) {
+		layers[i].animation = NULL;
+	}
+	if (!addWakeUpSource(&getNextKeyframeTime, &updateLedSequencer)) {
+		return FALSE;
+	}
+	isLedSequencerSetUp = TRUE;
+	return TRUE;
+}
+
+/**
+ * @copydoc tearDownLedSequencer
+ */
+int tearDownLedSequencer(void)
+{
+	if (!isLedSequencerSetUp) {
+		return FALSE;
+	}
+	for (int i = 0; i < NUM_OF_LED_LAYERS; i++) {
+		layers[i].animation = NULL;
+	}
+	removeWakeUpSource(&getNextKeyframeTime);
+	updateLedSequencer();
+	isLedSequencerSetUp = FALSE;
+	return TRUE;
+}
+
+/**
+ * @copydoc playLedAnimation
+ */
+int playLedAnimation(int layer, const LedAnimation *animation, UINT8 leds)
+{
+	if (!isLedSequencerSetUp || layer < 0 || layer >= NUM_OF_LED_LAYERS
+			|| animation->numberOfKeyframes == 0) {
+		return FALSE;
+	}
+	LedLayer *ledLayer = &layers[layer];
+
+	// keep a playing animation running:
+	if (ledLayer->animation == animation && ledLayer->leds == leds) {
+		return TRUE;
+	}
+	ledLayer->animation = animation;
+	ledLayer->leds = leds;
+	ledLayer->keyframe = 0;
+	ledLayer->keyframeEnd = getCurrentTime() + MILLISECONDS(animation->keyframes[0].duration);
+	ledLayer->loopDuration = 0;
+	for (int i = 0; i < animation->numberOfKeyframes; i++) {
+		ledLayer->loopDuration += MILLISECONDS(animation->keyframes[i].duration);
+	}
+	updateLedSequencer();
+	return TRUE;
+}
+
+/**
+ * @copydoc stopLedAnimation
+ */
+int stopLedAnimation(int layer)
+{
+	if (!isLedSequencerSetUp || layer < 0 || layer >= NUM_OF_LED_LAYERS) {
+		return FALSE;
+	}
+	if (layers[layer].animation) {
+		layers[layer].animation = NULL;
+		updateLedSequencer();
+	}
+	return TRUE;
+}
+
+/**
+ * @copydoc getNextKeyframeTime
+ */
+TIME getNextKeyframeTime(void)
+{
+	TIME nextKeyframeTime = NO_TIME;
+
+	for (int i = 0; i < NUM_OF_LED_LAYERS; i++) {
+		if (layers[i].animation && layers[i].keyframeEnd < nextKeyframeTime) {
+			nextKeyframeTime = layers[i].keyframeEnd;
+		}
+	}
+	return nextKeyframeTime;
+}
@@ -0,0 +1,93 @@
+/**
+ * @brief   Plays LED animations
+ *
+ * An animation is a constant table of keyframes, each one a pattern over
+ * the LEDs and the time it is shown. An animation is played on a layer and
+ * covers the LEDs it is played on: A higher layer covers the lower ones,
+ * and the LEDs which are not covered by any layer show their own state
+ * (see ledController.h). The layers are composited in one pass, so the
+ * cost of an update doesn't depend on the number of playing animations.
+ *
+ * @file    ledSequencer.h
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#ifndef LEDSEQUENCER_H_
+#define LEDSEQUENCER_H_
+
+#include "types.h"
+#include "timebase.h"
+
+/**
+ * Number of layers (one animation per layer)
+ */
+#define NUM_OF_LED_LAYERS	4
+
+/**
+ * A keyframe of an animation
+ */
+typedef struct {
+	UINT16 duration; /**< Time the pattern is shown in ms */
+	UINT8 pattern;   /**< LEDs which are on (LED_1, ...) */
+} LedKeyframe;
+
+/**
+ * An animation
+ */
+typedef struct {
+	const LedKeyframe *keyframes; /**< The keyframes */
+	UINT8 numberOfKeyframes;      /**< Number of keyframes */
+	UINT8 isLooping;              /**< TRUE to repeat, otherwise the last keyframe is held */
+} LedAnimation;
+
+/**
+ * Define an animation from a keyframe table
+ */
+#define LED_ANIMATION(keyframes, isLooping) \
+	{ (keyframes), sizeof(keyframes) / sizeof((keyframes)[0]), (isLooping) }
+
+/**
+ * Initialize LED sequencer
+ *
+ * @return Returns TRUE if initializing was successful
+ */
+extern int setUpLedSequencer(void);
+
+/**
+ * Clean up LED sequencer
+ *
+ * @return Returns TRUE if cleaning up was successful
+ */
+extern int tearDownLedSequencer(void);
+
+/**
+ * Play an animation
+ *
+ * Replaces the animation on the layer. If the same animation is already
+ * playing on the same LEDs, it continues.
+ *
+ * @param layer The layer (0 to NUM_OF_LED_LAYERS - 1, higher layers cover lower ones)
+ * @param animation The animation
+ * @param leds The LEDs the animation covers (the keyframes are masked with it)
+ * @return Returns TRUE if successful
+ */
+extern int playLedAnimation(int layer, const LedAnimation *animation, UINT8 leds);
+
+/**
+ * Stop the animation on a layer
+ *
+ * @param layer The layer
+ * @return Returns TRUE if successful
+ */
+extern int stopLedAnimation(int layer);
+
+/**
+ * Get the next time a keyframe starts
+ *
+ * @return Returns the next keyframe time or NO_TIME if no animation is playing
+ */
+extern TIME getNextKeyframeTime(void);
+
+#endif /* LEDSEQUENCER_H_ */
@@ -28,7 +28,9 @@
 #include "logic.h"
 #include "stateMachineEngine.h"
 #include "sensorController.h"
+#include "inputController.h"
 #include "machineController.h"
+#include "timebase.h"
 #include "timer.h"
 
 // =============================================================================
@@ -42,19 +44,13 @@
 /**
  * The initialization duration.
  */
-#define INITIALIZING_DURATION 2000
+#define INITIALIZING_DURATION MILLISECONDS(2000)
 /**
  * The warming up duration.
  */
-#define WARMING_UP_DURATION 1000
-/**
- * The milk delivery duration.
- */
-#define DELIVERING_MILK_DURATION 3000
-/**
- * The coffee delivery duration.
- */
-#define DELIVERING_COFFEE_DURATION 5000
+#define WARMING_UP_DURATION MILLISECONDS(1000)
+// The delivery durations are defined in logic.h, as the user interface
+// shows the delivery progress.
 
 // =============================================================================
 // Memory management interface
@@ -115,6 +111,23 @@ static void notifyObservers() {
 #endif
 }
 
+// =============================================================================
+// Timer event interface
+// =============================================================================
+
+/**
+ * Set if a timer handler has processed a state machine event since the last
+ * run of the business logic.
+ */
+static int isRunPending = FALSE;
+
+/**
+ * @copydoc isBusinessLogicRunPending
+ */
+int isBusinessLogicRunPending() {
+	return isRunPending;
+}
+
 // =============================================================================
 // Domain model types and instances
 // =============================================================================
@@ -169,6 +182,7 @@ typedef struct {
 	ProductListElement *products; /**< The product definition collection. */
 	MilkPreselectionState milkPreselectionState; /**< The milk preselection state. */
 	MakeCoffeeProcessInstance *ongoingCoffeeMaking; /**< A possibly ongoing coffee making process instance. */
+	unsigned int numberOfDeliveredProducts; /**< The number of products delivered since start up. */
 } CoffeeMaker;
 
 /**
@@ -329,6 +343,8 @@ typedef enum {
 	event_ingredientTankIsEmpty
 } CoffeeMakerEvent;
 
+static void processEvent(CoffeeMakerEvent event);
+
 // -----------------------------------------------------------------------------
 // Off state
 // -----------------------------------------------------------------------------
@@ -351,26 +367,30 @@ static State offState = {
 // Timers
 static TIMER initTimer;
 
+static void initializationFinished(void *context) {
+	initTimer = INVALID_TIMER;
+	isRunPending = TRUE;
+
+	processEvent(event_isInitialized);
+}
+
 static void initializingStateEntryAction() {
 	coffeeMaker.state = coffeeMaker_initializing;
 
-	initTimer = setUpTimer(INITIALIZING_DURATION);
+	initTimer = setUpCallbackTimer(INITIALIZING_DURATION, 0, &initializationFinished, NULL);
 
 	notifyObservers();
 }
 
-static Event initializingStateDoAction() {
-	if (isTimerElapsed(initTimer)) {
-		return event_isInitialized;
-	}
-
-	return NO_EVENT;
+static void initializingStateExitAction() {
+	abortTimer(initTimer);
+	initTimer = INVALID_TIMER;
 }
 
 static State initializingState = {
 	.stateIndex = coffeeMaker_initializing,
 	.entryAction = initializingStateEntryAction,
-	.doAction = initializingStateDoAction
+	.exitAction = initializingStateExitAction
 };
 
 // -----------------------------------------------------------------------------
@@ -519,7 +539,8 @@ typedef enum {
 	coffeeMakingEvent_milkDelivered,
 	coffeeMakingEvent_deliverCoffee,
 	coffeeMakingEvent_coffeeDelivered,
-	coffeeMakingEvent_ingredientTankIsEmpty
+	coffeeMakingEvent_ingredientTankIsEmpty,
+	coffeeMakingEvent_machineFault
 } CoffeeMakingEvent;
 
 // -----------------------------------------------------------------------------
@@ -529,26 +550,30 @@ typedef enum {
 // Timer
 static TIMER warmingUpTimer;
 
+static void warmingUpFinished(void *context) {
+	warmingUpTimer = INVALID_TIMER;
+	isRunPending = TRUE;
+
+	processStateMachineEvent(&coffeeMakingProcessMachine, coffeeMakingEvent_isWarmedUp);
+}
+
 static void warmingUpActivityEntryAction() {
 	coffeeMaker.ongoingCoffeeMaking->currentActivity = coffeeMakingActivity_warmingUp;
 
-	warmingUpTimer = setUpTimer(WARMING_UP_DURATION);
+	warmingUpTimer = setUpCallbackTimer(WARMING_UP_DURATION, 0, &warmingUpFinished, NULL);
 
 	notifyObservers();
 }
 
-static Event warmingUpActivityDoAction() {
-	if (isTimerElapsed(warmingUpTimer)) {
-		return coffeeMakingEvent_isWarmedUp;
-	}
-
-	return NO_EVENT;
+static void warmingUpActivityExitAction() {
+	abortTimer(warmingUpTimer);
+	warmingUpTimer = INVALID_TIMER;
 }
 
 static State warmingUpActivity = {
 	.stateIndex = coffeeMakingActivity_warmingUp,
 	.entryAction = warmingUpActivityEntryAction,
-	.doAction = warmingUpActivityDoAction
+	.exitAction = warmingUpActivityExitAction
 };
 
 // -----------------------------------------------------------------------------
@@ -583,14 +608,15 @@ static void deliveringMilkActivityEntryAction() {
 }
 
 static Event deliveringMilkActivityDoAction() {
-	if (!machineRunning()) {
-		return coffeeMakingEvent_milkDelivered;
-	}
-
 	if (!coffeeMaker.milk.isAvailable) {
 		return coffeeMakingEvent_ingredientTankIsEmpty;
 	}
 
+	// The delivery was interrupted by the watchdog
+	if (isMachineForcedSafe()) {
+		return coffeeMakingEvent_machineFault;
+	}
+
 	return NO_EVENT;
 }
 
@@ -618,14 +644,15 @@ static void deliveringCoffeeActivityEntryAction() {
 }
 
 static Event deliveringCoffeeActivityDoAction() {
-	if (!machineRunning()) {
-		return coffeeMakingEvent_coffeeDelivered;
-	}
-
 	if (!coffeeMaker.coffee.isAvailable) {
 		return coffeeMakingEvent_ingredientTankIsEmpty;
 	}
 
+	// The delivery was interrupted by the watchdog
+	if (isMachineForcedSafe()) {
+		return coffeeMakingEvent_machineFault;
+	}
+
 	return NO_EVENT;
 }
 
@@ -640,12 +667,46 @@ static State deliveringCoffeeActivity = {
 	.exitAction = deliveringCoffeeActivityExitAction
 };
 
+// -----------------------------------------------------------------------------
+// Machine observer
+// -----------------------------------------------------------------------------
+
+/**
+ * Gets called by the machine controller if the ingredient delivery is
+ * finished.
+ */
+static void ingredientDelivered() {
+	if (!coffeeMaker.ongoingCoffeeMaking) {
+		return;
+	}
+	isRunPending = TRUE;
+
+	// The watchdog interrupted the delivery before the time elapsed (e.g. the
+	// loop resumed after a stall and the timer fired before the do action ran)
+	if (isMachineForcedSafe()) {
+		processStateMachineEvent(&coffeeMakingProcessMachine, coffeeMakingEvent_machineFault);
+		return;
+	}
+
+	switch (coffeeMaker.ongoingCoffeeMaking->currentActivity) {
+	case coffeeMakingActivity_deliveringMilk:
+		processStateMachineEvent(&coffeeMakingProcessMachine, coffeeMakingEvent_milkDelivered);
+		break;
+	case coffeeMakingActivity_deliveringCoffee:
+		processStateMachineEvent(&coffeeMakingProcessMachine, coffeeMakingEvent_coffeeDelivered);
+		break;
+	default:
+		break;
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Finished state
 // -----------------------------------------------------------------------------
 
 static void finishedStateEntryAction() {
 	coffeeMaker.ongoingCoffeeMaking->currentActivity = coffeeMakingActivity_finished;
+	coffeeMaker.numberOfDeliveredProducts++;
 
 	notifyObservers();
 }
@@ -674,7 +735,7 @@ static State errorState = {
 // Activity/state transitions
 // -----------------------------------------------------------------------------
 static StateMachine coffeeMakingProcessMachine = {
-	.numberOfEvents = 6,
+	.numberOfEvents = 7,
 	.initialState = &warmingUpActivity,
 	.transitions = {
 		/* coffeeMakingActivity_warmingUp: */
@@ -684,6 +745,7 @@ static StateMachine coffeeMakingProcessMachine = {
 			/* coffeeMakingEvent_deliverCoffee: */ NULL,
 			/* coffeeMakingEvent_coffeeDelivered: */ NULL,
 			/* coffeeMakingEvent_ingredientTankIsEmpty: */ NULL,
+			/* coffeeMakingEvent_machineFault: */ NULL,
 		/* coffeeMakingActivity_withMilkGateway: */
 			/* coffeeMakingEvent_isWarmedUp: */ NULL,
 			/* coffeeMakingEvent_deliverMilk: */ &deliveringMilkActivity,
@@ -691,6 +753,7 @@ static StateMachine coffeeMakingProcessMachine = {
 			/* coffeeMakingEvent_deliverCoffee: */ &deliveringCoffeeActivity,
 			/* coffeeMakingEvent_coffeeDelivered: */ NULL,
 			/* coffeeMakingEvent_ingredientTankIsEmpty: */ NULL,
+			/* coffeeMakingEvent_machineFault: */ NULL,
 		/* coffeeMakingActivity_deliveringMilk: */
 			/* coffeeMakingEvent_isWarmedUp: */ NULL,
 			/* coffeeMakingEvent_deliverMilk: */ NULL,
@@ -698,13 +761,15 @@ static StateMachine coffeeMakingProcessMachine = {
 			/* coffeeMakingEvent_deliverCoffee: */ NULL,
 			/* coffeeMakingEvent_coffeeDelivered: */ NULL,
 			/* coffeeMakingEvent_ingredientTankIsEmpty: */ &errorState,
+			/* coffeeMakingEvent_machineFault: */ &errorState,
 		/* coffeeMakingActivity_deliveringCoffee: */
 			/* coffeeMakingEvent_isWarmedUp: */ NULL,
 			/* coffeeMakingEvent_deliverMilk: */ NULL,
 			/* coffeeMakingEvent_milkDelivered: */ NULL,
 			/* coffeeMakingEvent_deliverCoffee: */ NULL,
 			/* coffeeMakingEvent_coffeeDelivered: */ &finishedState,
-			/* coffeeMakingEvent_ingredientTankIsEmpty: */ &errorState
+			/* coffeeMakingEvent_ingredientTankIsEmpty: */ &errorState,
+			/* coffeeMakingEvent_machineFault: */ &errorState
 		}
 };
 
@@ -713,35 +778,42 @@ static StateMachine coffeeMakingProcessMachine = {
 // =============================================================================
 
 // Sensor states
-static enum SensorState lastEmptyCoffeeTankSensorState = sensor_unknown;
-static enum SensorState lastEmptyMilkTankSensorState = sensor_unknown;
+static int areTankSensorStatesKnown = FALSE;
 
 /**
  * Checks the ingredient tank sensors.
  */
 static void checkIngredientTankSensors() {
-	// Coffee sensor
-	enum SensorState emptyCoffeeTankSensorState = getSensorState(coffeeMaker.coffee.emptyTankSensorId);
-	// If sensor state has changed...
-	if (emptyCoffeeTankSensorState != lastEmptyCoffeeTankSensorState) {
-		// Update model
-		coffeeMaker.coffee.isAvailable = !(emptyCoffeeTankSensorState == sensor_alert);
+	// Take over the current sensor states once...
+	if (!areTankSensorStatesKnown) {
+		coffeeMaker.coffee.isAvailable = !(getSensorState(coffeeMaker.coffee.emptyTankSensorId) == sensor_alert);
+		coffeeMaker.milk.isAvailable = !(getSensorState(coffeeMaker.milk.emptyTankSensorId) == sensor_alert);
 
 		notifyObservers();
 
-		lastEmptyCoffeeTankSensorState = emptyCoffeeTankSensorState;
+		areTankSensorStatesKnown = TRUE;
+		return;
 	}
 
-	// Milk sensor
-	enum SensorState emptyMilkTankSensorState = getSensorState(coffeeMaker.milk.emptyTankSensorId);
-	// If sensor state has changed...
-	if (emptyMilkTankSensorState != lastEmptyMilkTankSensorState) {
-		// Update model
-		coffeeMaker.milk.isAvailable = !(emptyMilkTankSensorState == sensor_alert);
+	// ...then follow their changes
+	const QueuedInputEvent *events;
+	int numberOfEvents = getInputEvents(&events);
+	for (int i = 0; i < numberOfEvents; i++) {
+		// Coffee sensor
+		if (events[i].line == SENSOR_LINE(coffeeMaker.coffee.emptyTankSensorId)) {
+			// Update model
+			coffeeMaker.coffee.isAvailable = events[i].event == inputEvent_release;
 
-		notifyObservers();
+			notifyObservers();
+		}
+
+		// Milk sensor
+		if (events[i].line == SENSOR_LINE(coffeeMaker.milk.emptyTankSensorId)) {
+			// Update model
+			coffeeMaker.milk.isAvailable = events[i].event == inputEvent_release;
 
-		lastEmptyMilkTankSensorState = emptyMilkTankSensorState;
+			notifyObservers();
+		}
 	}
 }
 
@@ -765,6 +837,9 @@ int setUpBusinessLogic() {
 
 	setUpStateMachine(&stateMachine);
 
+	// Get notified if an ingredient is delivered
+	registerMachineStoppedObserver(&ingredientDelivered);
+
 	isBusinessLogicSetUp = TRUE;
 
 	return TRUE;
@@ -801,6 +876,8 @@ int tearDownBusinessLogic() {
  * @copydoc runBusinessLogic
  */
 void runBusinessLogic() {
+	isRunPending = FALSE;
+
 	// Check ingredient tank sensors
 	checkIngredientTankSensors();
 
@@ -823,7 +900,8 @@ CoffeeMakerViewModel getCoffeeMakerViewModel() {
 		.isMilkAvailable = coffeeMaker.milk.isAvailable,
 		.numberOfProducts = getNumberOfProducts(),
 		.milkPreselectionState = coffeeMaker.milkPreselectionState,
-		.isMakingCoffee = coffeeMaker.ongoingCoffeeMaking ? TRUE : FALSE
+		.isMakingCoffee = coffeeMaker.ongoingCoffeeMaking ? TRUE : FALSE,
+		.numberOfDeliveredProducts = coffeeMaker.numberOfDeliveredProducts
 	};
 
 	return coffeeMakerViewModel;
@@ -868,8 +946,6 @@ MakeCoffeeProcessInstanceViewModel getCoffeeMakingProcessInstanceViewModel() {
 // Operations presentation interface
 // =============================================================================
 
-static void processEvent(CoffeeMakerEvent event);
-
 /**
  * @copydoc switchOn
  */
@@ -13,6 +13,16 @@
 #define LOGIC_H_
 
 #include "model.h"
+#include "timebase.h"
+
+/**
+ * The milk delivery duration.
+ */
+#define DELIVERING_MILK_DURATION MILLISECONDS(3000)
+/**
+ * The coffee delivery duration.
+ */
+#define DELIVERING_COFFEE_DURATION MILLISECONDS(5000)
 
 /**
  * Sets up the business logic.
@@ -32,6 +42,14 @@ extern int tearDownBusinessLogic();
  */
 extern void runBusinessLogic();
 
+/**
+ * Checks if a timer handler has changed the state since the last run.
+ * The main controller runs the user interface and the business logic
+ * on the next tick then.
+ * @return Returns TRUE if the business logic has to run, otherwise FALSE.
+ */
+extern int isBusinessLogicRunPending();
+
 /**
  * A handler which will be called upon a model change.
  */
@@ -0,0 +1,144 @@
+/**
+ * @file   loopStatistics.c
+ * @author agent (agent@local)
+ * @date   Oct 17, 2026
+ * @brief  Contains the event loop statistics.
+ *
+ * Each statistic is a log-linear histogram: Every power of two range is
+ * divided into SUB_BUCKETS equally sized buckets, so the relative error of
+ * a reported value is below 1 / SUB_BUCKETS (6.25%) over the whole range.
+ * Values below 2 * SUB_BUCKETS nanoseconds are counted exactly.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "defines.h"
+#include "types.h"
+#include "timebase.h"
+#include "loopStatistics.h"
+
+/**
+ * Number of buckets per power of two range.
+ */
+#define SUB_BUCKET_BITS 4
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+/**
+ * Largest recorded value (2^40 ns are about 18 minutes). Larger values are
+ * counted in the last bucket.
+ */
+#define MAX_VALUE_BITS 40
+#define NUM_OF_BUCKETS ((MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS)
+
+/**
+ * A histogram.
+ */
+typedef struct {
+	UINT64 count; /**< Number of recorded values */
+	TIME max; /**< Largest recorded value */
+	UINT32 buckets[NUM_OF_BUCKETS];
+} Histogram;
+
+static Histogram histograms[NUM_OF_LOOP_STATISTICS];
+
+static const char *statisticNames[NUM_OF_LOOP_STATISTICS] = {
+	"Iteration duration",
+	"Iteration gap",
+	"Wake-up latency",
+	"Input latency",
+	"Action latency"
+};
+
+/**
+ * Gets the bucket of a value.
+ */
+static int getBucketIndex(TIME value) {
+	if (value < 2 * SUB_BUCKETS) {
+		return (int) value;
+	}
+
+	int shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+	int index = (shift + 1) * SUB_BUCKETS + (int) ((value >> shift) - SUB_BUCKETS);
+	if (index >= NUM_OF_BUCKETS) {
+		index = NUM_OF_BUCKETS - 1;
+	}
+	return index;
+}
+
+/**
+ * Gets the largest value counted in a bucket.
+ */
+static TIME getBucketUpperBound(int index) {
+	if (index < 2 * SUB_BUCKETS) {
+		return (TIME) index;
+	}
+
+	int shift = index / SUB_BUCKETS - 1;
+	TIME lowerBound = (TIME) (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+	return lowerBound + ((TIME) 1 << shift) - 1;
+}
+
+/**
+ * Gets a percentile of a histogram.
+ *
+ * @param histogram The histogram
+ * @param fraction The percentile in 1/10000 (e.g. 9990 for the 99.9th percentile)
+ */
+static TIME getPercentile(Histogram *histogram, UINT64 fraction) {
+	UINT64 rank = (histogram->count * fraction + 9999) / 10000;
+	UINT64 count = 0;
+
+	for (int i = 0; i < NUM_OF_BUCKETS; i++) {
+		count += histogram->buckets[i];
+		if (count >= rank) {
+			TIME value = getBucketUpperBound(i);
+			// Don't report more than was actually recorded
+			return value < histogram->max ? value : histogram->max;
+		}
+	}
+	return histogram->max;
+}
+
+/**
+ * @copydoc recordLoopStatistic
+ */
+void recordLoopStatistic(enum LoopStatistic statistic, TIME value) {
+	Histogram *histogram = &histograms[statistic];
+
+	histogram->buckets[getBucketIndex(value)]++;
+	histogram->count++;
+	if (value > histogram->max) {
+		histogram->max = value;
+	}
+}
+
+/**
+ * @copydoc resetLoopStatistics
+ */
+void resetLoopStatistics(void) {
+	memset(histograms, 0, sizeof(histograms));
+}
+
+/**
+ * @copydoc printLoopStatistics
+ */
+void printLoopStatistics(void) {
+	printf("Event loop statistics [us]:\n");
+	printf("%-20s %10s %10s %10s %10s %10s\n", "", "count", "p50", "p99", "p99.9", "max");
+	for (int i = 0; i < NUM_OF_LOOP_STATISTICS; i++) {
+		Histogram *histogram = &histograms[i];
+
+		if (histogram->count == 0) {
+			printf("%-20s %10d\n", statisticNames[i], 0);
+			continue;
+		}
+		printf("%-20s %10llu %10llu %10llu %10llu %10llu\n",
+				statisticNames[i],
+				histogram->count,
+				getPercentile(histogram, 5000) / MICROSECONDS(1),
+				getPercentile(histogram, 9900) / MICROSECONDS(1),
+				getPercentile(histogram, 9990) / MICROSECONDS(1),
+				histogram->max / MICROSECONDS(1));
+	}
+	fflush(stdout);
+}
@@ -0,0 +1,52 @@
+/**
+ * Event loop statistics
+ *
+ * Records the timing of the event loop into log-linear histograms, which
+ * can be printed as percentiles. Recording a value is cheap (a bit scan
+ * and an increment), so the statistics are always on.
+ *
+ * @file    loopStatistics.h
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#ifndef LOOPSTATISTICS_H_
+#define LOOPSTATISTICS_H_
+
+#include "timebase.h"
+
+/**
+ * Recorded loop statistics
+ */
+enum LoopStatistic {
+	loopStatistic_iterationDuration = 0, /**< Work time of one loop iteration */
+	loopStatistic_iterationGap,          /**< Time between the starts of two iterations */
+	loopStatistic_wakeUpLatency,         /**< Delay of a wake-up after its deadline */
+	loopStatistic_inputLatency,          /**< Delay from an input edge until it is read */
+	loopStatistic_actionLatency,         /**< Delay from an input change until it is handled */
+	NUM_OF_LOOP_STATISTICS
+};
+
+/**
+ * Record a value
+ *
+ * @param statistic The statistic to record the value into
+ * @param value The duration
+ */
+extern void recordLoopStatistic(enum LoopStatistic statistic, TIME value);
+
+/**
+ * Reset all statistics
+ */
+extern void resetLoopStatistics(void);
+
+/**
+ * Print all statistics
+ *
+ * Prints the number of recorded values as well as the 50th, 99th and
+ * 99.9th percentile and the maximum of each statistic to stdout.
+ */
+extern void printLoopStatistics(void);
+
+#endif /* LOOPSTATISTICS_H_ */
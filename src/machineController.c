@@ -15,9 +15,12 @@
 #include "timer.h"
 #include "hardwareController.h"
 #include "machineController.h"
+#include "watchdog.h"
 
 static TIMER timer;
+static NotifyMachineStopped machineStoppedObserver;
 static Mix_Music *sound; /* Pointer to our sound, in memory	*/
+static volatile int isForcedSafe = FALSE;
 static int isMachineControllerSetUp = FALSE;
 
 /**
@@ -140,10 +143,28 @@ static int stopSound()
 	return TRUE;
 }
 
+/**
+ * Stops the output process if the output time is elapsed
+ *
+ * @param context Not used
+ */
+static void outputTimeElapsed(void *context)
+{
+	// stop output and sound and invalidate timer handle:
+	writeActuators(0);
+	stopSound();
+	timer = INVALID_TIMER;
+
+	// notify the observer:
+	if (machineStoppedObserver) {
+		(*machineStoppedObserver)();
+	}
+}
+
 /**
  * @copydoc startMachine
  */
-int startMachine(enum Ingredient ing, unsigned int time)
+int startMachine(enum Ingredient ing, TIME time)
 {
 	// check if the machine controller is initialized:
 	if (!isMachineControllerSetUp) {
@@ -162,10 +183,15 @@ int startMachine(enum Ingredient ing, unsigned int time)
 		printf("Unknown ingredient selected!\n");
 		return FALSE;
 	}
+	isForcedSafe = FALSE;
+	// start ingredient specific output:
+	writeActuators(ing == ingredient_coffee ? ACTUATOR_COFFEE : ACTUATOR_MILK);
 	// play ingredient specific sound:
+	enum WatchdogPhase phase = setWatchdogPhase(watchdogPhase_sound);
 	playSound(ing);
+	setWatchdogPhase(phase);
 	// start timer:
-	timer = setUpTimer(time);
+	timer = setUpCallbackTimer(time, 0, &outputTimeElapsed, NULL);
 	return TRUE;
 }
 
@@ -176,11 +202,13 @@ int stopMachine(void)
 		return FALSE;
 	}
 
-	// if timer is still running stop it and stop sound:
-	if (timer) {
+	isForcedSafe = FALSE;
+	// if timer is still running stop it and stop output and sound:
+	if (timer != INVALID_TIMER) {
+		writeActuators(0);
 		stopSound();
 		abortTimer(timer);
-		timer = NULL;
+		timer = INVALID_TIMER;
 	}
 	return TRUE;
 }
@@ -194,16 +222,38 @@ int machineRunning(void)
 	if (!isMachineControllerSetUp) {
 		return FALSE;
 	}
-	// check for a timer pointer:
-	if (timer) {
-		// check if timer is still running:
-		if (!isTimerElapsed(timer)) {
-			return TRUE;
-		} else {
-			// stop sound and set timer pointer to NULL:
-			stopSound();
-			timer = NULL;
-		}
+	// the timer handle is invalidated when the output time is elapsed:
+	return timer != INVALID_TIMER;
+}
+
+/**
+ * @copydoc forceMachineSafe
+ */
+int forceMachineSafe(void)
+{
+	// check if the machine controller is initialized
+	if (!isMachineControllerSetUp) {
+		return FALSE;
 	}
-	return FALSE;
+	isForcedSafe = TRUE;
+	writeActuators(0);
+	// SDL_mixer locks the audio device itself:
+	Mix_HaltMusic();
+	return TRUE;
+}
+
+/**
+ * @copydoc isMachineForcedSafe
+ */
+int isMachineForcedSafe(void)
+{
+	return isForcedSafe;
+}
+
+/**
+ * @copydoc registerMachineStoppedObserver
+ */
+void registerMachineStoppedObserver(NotifyMachineStopped pObserver)
+{
+	machineStoppedObserver = pObserver;
 }
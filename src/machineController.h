@@ -9,6 +9,13 @@
 #ifndef MACHINECONTROLLER_H_
 #define MACHINECONTROLLER_H_
 
+#include "timebase.h"
+
+/**
+ * A handler which will be called if the machine stops after the output
+ * time is elapsed.
+ */
+typedef void (*NotifyMachineStopped)();
 
 enum Ingredient {
 	ingredient_coffee = 0, /**< ingredient_coffee */
@@ -33,10 +40,10 @@ extern int tearDownMachineController(void);
  * Starting process of putting out ingredients
  *
  * @param ing Ingretient type (milk or coffee)
- * @param time Output time in milliseconds
+ * @param time Output time
  * @return Returns TRUE if start was successful
  */
-extern int startMachine(enum Ingredient ing, unsigned int time);
+extern int startMachine(enum Ingredient ing, TIME time);
 
 /**
  * Stopping output process immediately
@@ -45,6 +52,35 @@ extern int startMachine(enum Ingredient ing, unsigned int time);
  */
 extern int stopMachine(void);
 
+/**
+ * Force the machine into a safe state
+ *
+ * Stops the output immediately. In contrast to all other functions it may
+ * be called from any thread, e.g. by the watchdog if the event loop is
+ * stalled. The machine stays forced safe until it is started or stopped
+ * the next time.
+ *
+ * @return Returns TRUE if successful
+ */
+extern int forceMachineSafe(void);
+
+/**
+ * Check if the machine was forced into a safe state
+ *
+ * @return Returns TRUE if the machine was forced safe
+ */
+extern int isMachineForcedSafe(void);
+
+/**
+ * Register machine stopped observer
+ *
+ * The observer is called when the output time given to startMachine()
+ * is elapsed, but not if the machine is stopped with stopMachine().
+ *
+ * @param pObserver The observer
+ */
+extern void registerMachineStoppedObserver(NotifyMachineStopped pObserver);
+
 /**
  * Check if machine is still running
  *
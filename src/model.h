@@ -43,6 +43,7 @@ typedef struct {
 	unsigned int numberOfProducts; /**< The number of defined products. */
 	int milkPreselectionState; /**< The milk preselection state. */
 	int isMakingCoffee; /**< Is the coffee maker currently making coffee? */
+	unsigned int numberOfDeliveredProducts; /**< The number of products delivered since start up. */
 } CoffeeMakerViewModel;
 
 /**
@@ -9,11 +9,21 @@
  * \remark  Last Modifications:
  * \remark  V1.0, AOM1, 28.08.07   Initial release
  * \remark  V1.1, 02.06.2011       File renamed from original name gpio.c
+ * \remark  V1.2, agent, 17.10.2026  Register addresses 64 bit clean
+ * \remark  V1.3, agent, 17.10.2026  Edge detection of the buttons
+ * \remark  V1.4, agent, 17.10.2026  LEDs written per bank, access counter
+ * \remark  V1.5, agent, 17.10.2026  Pins configured from a table
+ * \remark  V1.6, agent, 17.10.2026  Mux read once with a calibrated settle time
+ * \remark  V1.7, agent, 17.10.2026  7-segment digits on the LED port
+ * \remark  V1.8, agent, 17.10.2026  Mux read twice if not calibrated
+ * \remark  V1.9, agent, 17.10.2026  LEDs and digits take turns on the port
  *
  ***************************************************************************
  */
 
+#include "defines.h"
 #include "types.h"
+#include "pinConfig.h"
 #include "orchid.h"
 
 /*
@@ -23,6 +33,9 @@
  */
 
 extern void *mmap_base;
+extern void *timer_base;
+
+unsigned long GPIO_access_count = 0;
 
 /*
  ***************************************************************************
@@ -30,7 +43,63 @@ extern void *mmap_base;
  ***************************************************************************
  */
 
-void *regaddr;
+/* Mux positions and how long the lines take to settle after a switch */
+#define MUX_SWITCHES	SET
+#define MUX_BUTTONS	CLEAR
+#define MUX_UNKNOWN	0
+
+#define MUX_SETTLE_MAX		(100 * OSCR_TICKS_PER_MS / 1000)	/* 100 us */
+#define MUX_CALIBRATION_TRIALS	20
+
+static UINT32 mux_position = MUX_UNKNOWN;
+static UINT32 mux_settle_ticks = MUX_SETTLE_MAX;
+static UINT32 mux_is_calibrated = FALSE;
+
+/* Whether the LEDs are selected (GPIO 118 high) or a digit uses the port */
+static UINT32 leds_selected = TRUE;
+
+static const UINT32 segment_enables[4] =
+ {
+  SEGMENT_ENABLE_1, SEGMENT_ENABLE_2, SEGMENT_ENABLE_3, SEGMENT_ENABLE_4
+ };
+
+/* Bank and bit of the LED pins (the port), in the order of the pattern bits */
+typedef struct
+ {
+  UINT32 bank;
+  UINT32 bit;
+ } LED_pin;
+
+#define LED_PIN(gpio)	{ (gpio) / BIT_SIZE_32, 1UL << ((gpio) % BIT_SIZE_32) }
+
+/* The pins of the board */
+#define OUTPUT(gpio, level)	{ gpio, pinFunction_gpio, pinDirection_out, level, FALSE }
+#define INPUT(gpio)		{ gpio, pinFunction_gpio, pinDirection_in, pinLevel_low, TRUE }
+
+static const PinConfig orchid_pins[] =
+ {
+  /* LEDs and 7-Segment port */
+  OUTPUT(GPIO_PIN_35, pinLevel_low), OUTPUT(GPIO_PIN_37, pinLevel_low),
+  OUTPUT(GPIO_PIN_36, pinLevel_low), OUTPUT(GPIO_PIN_79, pinLevel_low),
+  OUTPUT(GPIO_PIN_15, pinLevel_low), OUTPUT(GPIO_PIN_80, pinLevel_low),
+  OUTPUT(GPIO_PIN_52, pinLevel_low), OUTPUT(GPIO_PIN_19, pinLevel_low),
+
+  /* 7-Segment enable */
+  OUTPUT(23, pinLevel_low), OUTPUT(24, pinLevel_low),
+  OUTPUT(25, pinLevel_low), OUTPUT(26, pinLevel_low),
+
+  /* Buttons and Switches, the edges of the buttons are latched */
+  INPUT(12), INPUT(11), INPUT(17), INPUT(16),
+
+  /* Mux selection: buttons and LED */
+  OUTPUT(117, pinLevel_low), OUTPUT(LED_SELECT_PIN, pinLevel_high)
+ };
+
+static const LED_pin led_pins[8] =
+ {
+  LED_PIN(GPIO_PIN_35), LED_PIN(GPIO_PIN_37), LED_PIN(GPIO_PIN_36), LED_PIN(GPIO_PIN_79),
+  LED_PIN(GPIO_PIN_15), LED_PIN(GPIO_PIN_80), LED_PIN(GPIO_PIN_52), LED_PIN(GPIO_PIN_19)
+ };
 
 /*
  ***************************************************************************
@@ -40,8 +109,12 @@ void *regaddr;
 
 static void GPIO_putmem(UINT32 addr, UINT32 val)
  {
-   regaddr = (void*) ((UINT32) mmap_base + (addr & MAP_MASK));
-   *(UINT32*) regaddr = val;
+   /* Local, as the LEDs and the digits are written by different threads */
+   void *regaddr;
+
+   regaddr = (void*) ((char *) mmap_base + (addr & MAP_MASK));
+   *(volatile UINT32*) regaddr = val;
+   GPIO_access_count++;
  }
 
 /*
@@ -53,9 +126,11 @@ static void GPIO_putmem(UINT32 addr, UINT32 val)
 static UINT32 GPIO_getmem(UINT32 addr)
  {
     UINT32 val;
+    void *regaddr;
 
-    regaddr = (void*) ((UINT32) mmap_base + (addr & MAP_MASK));
-    val = *(UINT32*) regaddr;
+    regaddr = (void*) ((char *) mmap_base + (addr & MAP_MASK));
+    val = *(volatile UINT32*) regaddr;
+    GPIO_access_count++;
     return val;
  }
 
@@ -99,75 +174,91 @@ static void GPIO_clear(UINT32 gpio)
 
 /*
  ***************************************************************************
- * Get the logic level of GPIO
+ * Get the register of a bank (bank 3 is not next to the others)
  ***************************************************************************
  */
 
-static UINT32 GPIO_status(UINT32 gpio)
+static UINT32 GPIO_bank_register(UINT32 reg0, UINT32 reg3, UINT32 bank)
  {
-    UINT32 pos;
-    UINT32 bit = 1;
-    UINT32 data;
-
-    pos = gpio / BIT_SIZE_32;
-    bit <<= gpio % BIT_SIZE_32;
-    if (gpio > 84)
-     data = GPIO_getmem(GPLR3);
-    else
-     data = GPIO_getmem(GPLR0 + (pos * 4));
-    data &= bit;
-    if (data == 0)
-      return(0);
-    else
-      return(1);
+  if (bank == 3)
+   return reg3;
+  return reg0 + (bank * 4);
  }
 
 /*
  ***************************************************************************
- * Set the direction of a GPIO
+ * Read-modify-write a register
  ***************************************************************************
  */
 
-static void GPIO_direction(UINT32 gpio, UINT32 dir)
+static void GPIO_modify(UINT32 addr, UINT32 mask, UINT32 val)
  {
-    UINT32 pos;
-    UINT32 bit = 1;
-    UINT32 data;
-
-    pos = gpio / BIT_SIZE_32;
-    bit <<= gpio % BIT_SIZE_32;
-    if (gpio > 84)
-     data = GPIO_getmem(GPDR3);
-    else
-     data = GPIO_getmem(GPDR0 + (pos * 4));
-    data &= ~bit;
-    if (dir == OUT)
-      data |= bit;
-    if (gpio > 84)
-     GPIO_putmem(GPDR3, data);
-    else
-     GPIO_putmem(GPDR0 + (pos * 4), data);
+  GPIO_putmem(addr, (GPIO_getmem(addr) & ~mask) | val);
  }
 
 /*
  ***************************************************************************
- * Set as a GPIO funct
+ * Configure pins
  ***************************************************************************
  */
 
-static void GPIO_function(UINT32 gpio, UINT32 fun)
+void GPIO_configure(const PinConfig *pins, int count)
  {
-    UINT32 pos;
-    UINT32 bit = 3;
-    UINT32 data;
-
-    pos = gpio / BIT_SIZE_16;
-    bit <<= (gpio % BIT_SIZE_16) * 2;
-    fun <<= (gpio % BIT_SIZE_16) * 2;
-    data = GPIO_getmem(GAFR0_L + (pos * 4));
-    data &= ~bit;
-    data |= fun;
-    GPIO_putmem(GAFR0_L + (pos * 4), data);
+  UINT32 af_mask[8] = { 0 }, af_val[8] = { 0 };
+  UINT32 dir_mask[4] = { 0 }, dir_val[4] = { 0 };
+  UINT32 set[4] = { 0 }, clear[4] = { 0 };
+  UINT32 edges[4] = { 0 };
+  UINT32 bank, bit, shift;
+  int i;
+
+  /* Fold the pins into the bits of each register */
+  for (i = 0; i < count; i++)
+   {
+    bank = pins[i].gpio / BIT_SIZE_32;
+    bit = 1UL << (pins[i].gpio % BIT_SIZE_32);
+    shift = (pins[i].gpio % BIT_SIZE_16) * 2;
+
+    af_mask[pins[i].gpio / BIT_SIZE_16] |= 3UL << shift;
+    af_val[pins[i].gpio / BIT_SIZE_16] |= (UINT32) pins[i].function << shift;
+    dir_mask[bank] |= bit;
+    if (pins[i].direction == pinDirection_out)
+     {
+      dir_val[bank] |= bit;
+      if (pins[i].level == pinLevel_high)
+       set[bank] |= bit;
+      else
+       clear[bank] |= bit;
+     }
+    else if (pins[i].detectEdges)
+     edges[bank] |= bit;
+   }
+
+  /* Functions first, then the output levels, so that the outputs start
+     with their level when the direction is set last */
+  for (i = 0; i < 8; i++)
+   if (af_mask[i])
+    GPIO_modify(GAFR0_L + (i * 4), af_mask[i], af_val[i]);
+
+  for (i = 0; i < 4; i++)
+   {
+    if (set[i])
+     GPIO_putmem(GPIO_bank_register(GPSR0, GPSR3, i), set[i]);
+    if (clear[i])
+     GPIO_putmem(GPIO_bank_register(GPCR0, GPCR3, i), clear[i]);
+   }
+
+  for (i = 0; i < 4; i++)
+   if (dir_mask[i])
+    GPIO_modify(GPIO_bank_register(GPDR0, GPDR3, i), dir_mask[i], dir_val[i]);
+
+  /* Latch both edges, clear the edges of the setup */
+  for (i = 0; i < 4; i++)
+   if (edges[i])
+    {
+     GPIO_modify(GPIO_bank_register(GRER0, GRER3, i), 0, edges[i]);
+     GPIO_modify(GPIO_bank_register(GFER0, GFER3, i), 0, edges[i]);
+     GPIO_putmem(GPIO_bank_register(GEDR0, GEDR3, i), edges[i]);
+    }
  }
 
 /*
@@ -178,74 +269,27 @@ static void GPIO_function(UINT32 gpio, UINT32 fun)
 
 void GPIO_init(void)
  {
-  /* Set GPIO functions of the LED and 7-Segment port first */
-  GPIO_function(35, GPIO);
-  GPIO_function(37, GPIO);
-  GPIO_function(36, GPIO);
-  GPIO_function(79, GPIO);
-  GPIO_function(15, GPIO);
-  GPIO_function(80, GPIO);
-  GPIO_function(52, GPIO);
-  GPIO_function(19, GPIO);
-
-  /* Set GPIO functions 7-Segment enable */
-  GPIO_function(23, GPIO);
-  GPIO_function(24, GPIO);
-  GPIO_function(25, GPIO);
-  GPIO_function(26, GPIO);
-
-  /* Buttons and Switches */
-  GPIO_function(12, GPIO);
-  GPIO_function(11, GPIO);
-  GPIO_function(16, GPIO);
-  GPIO_function(17, GPIO);
-  GPIO_function(117, GPIO);
-  GPIO_function(118, GPIO);
-
-  /* Then set the direction for the LED and 7-Segment port */
-  GPIO_direction(35, OUT);
-  GPIO_direction(37, OUT);
-  GPIO_direction(36, OUT);
-  GPIO_direction(79, OUT);
-  GPIO_direction(15, OUT);
-  GPIO_direction(80, OUT);
-  GPIO_direction(52, OUT);
-  GPIO_direction(19, OUT);
-
-  /* Enable 7-Segment Digits */
-  GPIO_direction(23, OUT);
-  GPIO_direction(24, OUT);
-  GPIO_direction(25, OUT);
-  GPIO_direction(26, OUT);
-
-  /* Turn all off */
-  GPIO_clear(35);
-  GPIO_clear(37);
-  GPIO_clear(36);
-  GPIO_clear(79);
-  GPIO_clear(15);
-  GPIO_clear(80);
-  GPIO_clear(52);
-  GPIO_clear(19);
-
-  GPIO_clear(23);
-  GPIO_clear(24);
-  GPIO_clear(25);
-  GPIO_clear(26);
-
-  /* Buttons and Switches */
-  GPIO_direction(12, IN);
-  GPIO_direction(11, IN);
-  GPIO_direction(17, IN);
-  GPIO_direction(16, IN);
-
-  /* Mux selection */
-  GPIO_direction(117, OUT);
-  GPIO_direction(118, OUT);
+  GPIO_configure(orchid_pins, sizeof(orchid_pins) / sizeof(orchid_pins[0]));
+  leds_selected = TRUE;
+ }
 
-  /* Select LED */
-  GPIO_set(118);
+/*
+ ***************************************************************************
+ * Collect the bits of a port pattern per bank
+ ***************************************************************************
+ */
+
+static void GPIO_port_banks(UINT8 pattern, UINT32 *set, UINT32 *clear)
+ {
+  int i;
 
+  for (i = 0; i < 8; i++)
+   {
+    if (pattern & (1 << i))
+     set[led_pins[i].bank] |= led_pins[i].bit;
+    else
+     clear[led_pins[i].bank] |= led_pins[i].bit;
+   }
  }
 
 /*
@@ -256,45 +300,131 @@ void GPIO_init(void)
 
 void GPIO_write_led(UINT8 pattern)
  {
-  if (pattern & 0x01)
-   GPIO_set(35);
-  else
-   GPIO_clear(35);
+  UINT32 set[3] = { 0, 0, 0 };
+  UINT32 clear[3] = { 0, 0, 0 };
+  int i;
 
-  if (pattern & 0x02)
-   GPIO_set(37);
-  else
-   GPIO_clear(37);
+  /* Collect the bits per bank, then write each bank at once */
+  GPIO_port_banks(pattern, set, clear);
 
-  if (pattern & 0x04)
-   GPIO_set(36);
-  else
-   GPIO_clear(36);
+  /* Blank the digit before the port changes */
+  if (!leds_selected)
+   clear[0] |= SEGMENT_ENABLES;
 
-  if (pattern & 0x08)
-   GPIO_set(79);
-  else
-   GPIO_clear(79);
+  for (i = 0; i < 3; i++)
+   if (clear[i])
+    GPIO_putmem(GPCR0 + (i * 4), clear[i]);
+  for (i = 0; i < 3; i++)
+   if (set[i])
+    GPIO_putmem(GPSR0 + (i * 4), set[i]);
 
-  if (pattern & 0x10)
-   GPIO_set(15);
-  else
-   GPIO_clear(15);
+  /* Select LED */
+  if (!leds_selected)
+   {
+    GPIO_set(LED_SELECT_PIN);
+    leds_selected = TRUE;
+   }
+ }
 
-  if (pattern & 0x20)
-   GPIO_set(80);
-  else
-   GPIO_clear(80);
+/*
+ ***************************************************************************
+ * Show the segments on a digit of the 7-segment display
+ ***************************************************************************
+ */
 
-  if (pattern & 0x40)
-   GPIO_set(52);
-  else
-   GPIO_clear(52);
+void GPIO_write_digit(UINT32 digit, UINT8 segments)
+ {
+  UINT32 set[3] = { 0, 0, 0 };
+  UINT32 clear[3] = { 0, 0, 0 };
+  int i;
+
+  /* Deselect the LEDs before the port is used for the segments */
+  if (leds_selected)
+   {
+    GPIO_clear(LED_SELECT_PIN);
+    leds_selected = FALSE;
+   }
+
+  GPIO_port_banks(segments, set, clear);
+
+  /* Blank the digits while the segments change, bank 0 with the
+     enable of the digit goes last */
+  clear[0] |= SEGMENT_ENABLES;
+  set[0] |= segment_enables[digit % 4];
+
+  for (i = 0; i < 3; i++)
+   if (clear[i])
+    GPIO_putmem(GPCR0 + (i * 4), clear[i]);
+  for (i = 2; i >= 0; i--)
+   if (set[i])
+    GPIO_putmem(GPSR0 + (i * 4), set[i]);
+ }
 
-  if (pattern & 0x80)
-   GPIO_set(19);
+/*
+ ***************************************************************************
+ * Wait for a number of OS timer ticks
+ ***************************************************************************
+ */
+
+static void GPIO_wait(UINT32 ticks)
+ {
+  volatile UINT32 *oscr;
+  UINT32 start;
+
+  if (timer_base == NULL)
+   return;
+  oscr = (volatile UINT32 *) ((char *) timer_base + (OSCR0 & MAP_MASK));
+  start = *oscr;
+  while (*oscr - start < ticks)
+   ;
+ }
+
+/*
+ ***************************************************************************
+ * Select a mux position again and read its four lines one by one, like the
+ * first of the two reads before the settle time was calibrated
+ ***************************************************************************
+ */
+
+static void GPIO_read_mux_dummy(UINT32 position)
+ {
+  int i;
+
+  if (position == MUX_SWITCHES)
+   GPIO_set(117);
   else
-   GPIO_clear(19);
+   GPIO_clear(117);
+  for (i = 0; i < 4; i++)
+   GPIO_getmem(GPLR0);
+ }
+
+/*
+ ***************************************************************************
+ * Select a mux position and read its four lines at once
+ ***************************************************************************
+ */
+
+static UINT8 GPIO_read_mux(UINT32 position)
+ {
+  UINT32 level;
+
+  /* Only wait if the mux is switched */
+  if (position != mux_position)
+   {
+    if (position == MUX_SWITCHES)
+     GPIO_set(117);
+    else
+     GPIO_clear(117);
+    if (mux_is_calibrated)
+     GPIO_wait(mux_settle_ticks);
+    else
+     GPIO_read_mux_dummy(position);
+    mux_position = position;
+   }
+
+  level = GPIO_getmem(GPLR0);
+  return (((level & INPUT_PIN_4) ? 0x08 : 0) | ((level & INPUT_PIN_3) ? 0x04 : 0)
+    | ((level & INPUT_PIN_2) ? 0x02 : 0) | ((level & INPUT_PIN_1) ? 0x01 : 0));
  }
 
 /*
@@ -305,14 +435,7 @@ void GPIO_write_led(UINT8 pattern)
 
 UINT8 GPIO_read_switch(void)
  {
-  UINT8 sw1, sw2, sw3, sw4;
-
-  GPIO_set(117);
-  sw1 = GPIO_status(12);
-  sw2 = GPIO_status(11);
-  sw3 = GPIO_status(17);
-  sw4 = GPIO_status(16);
-  return ((sw4 << 3) | (sw3 << 2) | (sw2 << 1) | (sw1));
+  return GPIO_read_mux(MUX_SWITCHES);
  }
 
 /*
@@ -323,12 +446,83 @@ UINT8 GPIO_read_switch(void)
 
 UINT8 GPIO_read_button(void)
  {
-  UINT8 bt1, bt2, bt3, bt4;
-
-  GPIO_clear(117);
-  bt1 = GPIO_status(12);
-  bt2 = GPIO_status(11);
-  bt3 = GPIO_status(17);
-  bt4 = GPIO_status(16);
-  return ((bt4 << 3) | (bt3 << 2) | (bt2 << 1) | (bt1));
+  UINT32 position = mux_position;
+  UINT8 buttons;
+
+  buttons = GPIO_read_mux(MUX_BUTTONS);
+
+  /* The buttons stay selected, forget the edges caused by the mux */
+  if (position != MUX_BUTTONS)
+   GPIO_putmem(GEDR0, INPUT_PINS);
+  return buttons;
+ }
+
+/*
+ ***************************************************************************
+ * Find the shortest settle time of the mux
+ ***************************************************************************
+ */
+
+UINT32 GPIO_calibrate_mux(void)
+ {
+  UINT8 switches, buttons;
+  UINT32 ticks;
+  int i;
+
+  /* Reference with the longest settle time */
+  mux_is_calibrated = TRUE;
+  mux_settle_ticks = MUX_SETTLE_MAX;
+  mux_position = MUX_UNKNOWN;
+  switches = GPIO_read_switch();
+  buttons = GPIO_read_button();
+
+  /* At least one line has to read different in both positions, else a
+     short settle time could not be told from a long one (e.g. all switches
+     off and no button pressed). The lines are read twice then. */
+  if (switches == buttons)
+   {
+    mux_is_calibrated = FALSE;
+    return 0;
+   }
+
+  for (ticks = 0; ticks < MUX_SETTLE_MAX; ticks++)
+   {
+    mux_settle_ticks = ticks;
+    for (i = 0; i < MUX_CALIBRATION_TRIALS; i++)
+     if (GPIO_read_switch() != switches || GPIO_read_button() != buttons)
+      break;
+    if (i == MUX_CALIBRATION_TRIALS)
+     break;
+   }
+
+  /* The inputs must not have changed during the calibration */
+  mux_settle_ticks = MUX_SETTLE_MAX;
+  if (GPIO_read_switch() != switches || GPIO_read_button() != buttons)
+   {
+    mux_is_calibrated = FALSE;
+    return 0;
+   }
+
+  /* Keep a margin */
+  mux_settle_ticks = ticks * 2 + 1;
+  if (mux_settle_ticks > MUX_SETTLE_MAX)
+   mux_settle_ticks = MUX_SETTLE_MAX;
+  return mux_settle_ticks;
+ }
+
+/*
+ ***************************************************************************
+ * Read and clear the button edges since the last read of the buttons
+ ***************************************************************************
+ */
+
+UINT8 GPIO_read_button_edges(void)
+ {
+  UINT32 edges;
+
+  /* Writing a 1 clears the edge status */
+  edges = GPIO_getmem(GEDR0) & INPUT_PINS;
+  GPIO_putmem(GEDR0, edges);
+  return (((edges & INPUT_PIN_4) ? 0x08 : 0) | ((edges & INPUT_PIN_3) ? 0x04 : 0)
+    | ((edges & INPUT_PIN_2) ? 0x02 : 0) | ((edges & INPUT_PIN_1) ? 0x01 : 0));
  }
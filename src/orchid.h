@@ -9,12 +9,21 @@
  * \remark  Last Modifications:
  * \remark  V1.0, AOM1, 28.08.07   Initial release
  * \remark  V1.1, AOM1, 08.06.09   Added some more registers
+ * \remark  V1.2, agent, 17.10.2026  Edge detection of the buttons
+ * \remark  V1.3, agent, 17.10.2026  LEDs written per bank, access counter
+ * \remark  V1.4, agent, 17.10.2026  Pins configured from a table
+ * \remark  V1.5, agent, 17.10.2026  OS timer, mux calibration
+ * \remark  V1.6, agent, 17.10.2026  7-segment digits
+ * \remark  V1.7, agent, 17.10.2026  Mux read twice if not calibrated
+ * \remark  V1.8, agent, 17.10.2026  LEDs and digits take turns on the port
  ***************************************************************************
  */
 
 #ifndef ORCHID_H_
 #define ORCHID_H_
 
+#include "pinConfig.h"
+
 /****************************************************************************
  * Definitions General Purpose I/O
  ****************************************************************************/
@@ -64,6 +73,14 @@
 #define GFER3	0x40E0013C  /* GPIO Falling-Edge Detect Register GPIO<127:96> */
 #define GEDR3	0x40E00148  /* GPIO Edge Detect Status Register GPIO<127:96> */
 
+/****************************************************************************
+ * Definitions OS Timer
+ ****************************************************************************/
+
+#define OSCR0	0x40A00010  /* OS Timer Count Register, 3.25 MHz */
+
+#define OSCR_TICKS_PER_MS	3250
+
 /****************************************************************************
  * Definitions
  ****************************************************************************/
@@ -90,23 +107,49 @@
 #define	GPIO_PIN_52	52
 #define	GPIO_PIN_19	19
 
+/* Pins of the buttons and switches (muxed by GPIO 117), all in GPIO<31:0> */
+#define INPUT_PIN_1	(1 << 12)
+#define INPUT_PIN_2	(1 << 11)
+#define INPUT_PIN_3	(1 << 17)
+#define INPUT_PIN_4	(1 << 16)
+#define INPUT_PINS	(INPUT_PIN_1 | INPUT_PIN_2 | INPUT_PIN_3 | INPUT_PIN_4)
+
 #define SEGMENT_ENABLE_1	(1 << 23)
 #define SEGMENT_ENABLE_2	(1 << 24)
 #define SEGMENT_ENABLE_3	(1 << 25)
 #define SEGMENT_ENABLE_4	(1 << 26)
+#define SEGMENT_ENABLES	(SEGMENT_ENABLE_1 | SEGMENT_ENABLE_2 | SEGMENT_ENABLE_3 | SEGMENT_ENABLE_4)
+
+/* The LEDs and the 7-segment digits share the port (the LED pins). GPIO 118
+   is the mux selection of the LEDs (high: LEDs selected), a digit shows the
+   port while it is enabled. The LEDs and the digits take turns on the port.
+   That the LEDs are off while GPIO 118 is low is not verified on the board
+   yet */
+#define LED_SELECT_PIN	118
 
 #define MAP_SIZE  4096
 #define MAP_MASK (MAP_SIZE - 1)
 #define IO_BASE	 (0x40E00000 & ~MAP_MASK)
+#define OST_BASE (0x40A00000 & ~MAP_MASK)
+
+/****************************************************************************
+ * Public Variables
+ ****************************************************************************/
+
+extern unsigned long GPIO_access_count;  /* Number of register accesses */
 
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
 
+void  GPIO_configure(const PinConfig *pins, int count);
 void  GPIO_init(void);
 void  GPIO_write_led(UINT8 pattern);
+void  GPIO_write_digit(UINT32 digit, UINT8 segments);
 UINT8 GPIO_read_switch(void);
 UINT8 GPIO_read_button(void);
+UINT8 GPIO_read_button_edges(void);
+UINT32 GPIO_calibrate_mux(void);       /* Settle ticks, 0: read twice */
 
 #endif /* ORCHID_H_ */
 
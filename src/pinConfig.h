@@ -0,0 +1,56 @@
+/**
+ * @brief   Pin configuration of a board
+ *
+ * A board describes its pins as a table, which is applied at once when
+ * the board is set up (see GPIO_configure() in orchid.c and
+ * setUpCarmeGPIO() in carme.c). So a new pin is a new table entry.
+ *
+ * @file    pinConfig.h
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#ifndef PINCONFIG_H_
+#define PINCONFIG_H_
+
+#include "types.h"
+
+/**
+ * Predefined pin functions
+ */
+enum PinFunction {
+  pinFunction_gpio = 0, /**< general purpose I/O  */
+  pinFunction_alt1,     /**< alternate function 1 */
+  pinFunction_alt2,     /**< alternate function 2 */
+  pinFunction_alt3      /**< alternate function 3 */
+};
+
+/**
+ * Predefined pin directions
+ */
+enum PinDirection {
+  pinDirection_in = 0, /**< pinDirection_in  */
+  pinDirection_out     /**< pinDirection_out */
+};
+
+/**
+ * Predefined pin levels
+ */
+enum PinLevel {
+  pinLevel_low = 0, /**< pinLevel_low  */
+  pinLevel_high     /**< pinLevel_high */
+};
+
+/**
+ * Configuration of a pin
+ */
+typedef struct {
+	UINT32 gpio;                 /**< GPIO number */
+	enum PinFunction function;   /**< Function */
+	enum PinDirection direction; /**< Direction */
+	enum PinLevel level;         /**< Initial level of an output */
+	int detectEdges;             /**< TRUE to latch the edges of an input */
+} PinConfig;
+
+#endif /* PINCONFIG_H_ */
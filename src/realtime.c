@@ -0,0 +1,153 @@
+/**
+ * @file   realtime.c
+ * @author agent (agent@local)
+ * @date   Oct 17, 2026
+ * @brief  Contains the real-time mode.
+ *
+ * The real-time mode...
+ * - schedules the event loop thread with SCHED_FIFO, so it preempts the
+ *   GUI and audio threads,
+ * - locks all current and future memory (mlockall) and keeps freed heap
+ *   memory in the process, so no page has to be faulted in later on,
+ * - prefaults the stack,
+ * - optionally pins the event loop thread to one CPU.
+ *
+ * Once per CHECK_INTERVAL the page faults and involuntary context switches
+ * of the thread are read (getrusage) and reported if there were any.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "defines.h"
+#include "timebase.h"
+#include "timer.h"
+#include "realtime.h"
+
+/**
+ * The stack size which is prefaulted.
+ */
+#define PREFAULT_STACK_SIZE (64 * 1024)
+/**
+ * The interval of the steady state check.
+ * The first interval after setting up is not part of the steady state.
+ */
+#define CHECK_INTERVAL SECONDS(1)
+
+static TIMER checkTimer = INVALID_TIMER;
+static int isSteadyState = FALSE;
+static struct rusage lastUsage;
+static long pageFaults = 0;
+static long contextSwitches = 0;
+static int isRealtimeModeSetUp = FALSE;
+
+/**
+ * Touches the stack, so it is mapped before the real-time work starts.
+ */
+static void prefaultStack(void) {
+	volatile unsigned char stack[PREFAULT_STACK_SIZE];
+
+	memset((unsigned char *) stack, 0, PREFAULT_STACK_SIZE);
+}
+
+/**
+ * Checks for page faults and involuntary context switches since the
+ * last check.
+ */
+static void checkSteadyState(void *context) {
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_THREAD, &usage) < 0) {
+		return;
+	}
+
+	if (isSteadyState) {
+		long newPageFaults = (usage.ru_minflt - lastUsage.ru_minflt) + (usage.ru_majflt - lastUsage.ru_majflt);
+		long newContextSwitches = usage.ru_nivcsw - lastUsage.ru_nivcsw;
+
+		if (newPageFaults || newContextSwitches) {
+			printf("Real-time mode: %ld page faults and %ld involuntary context switches in steady state!\n",
+					newPageFaults, newContextSwitches);
+		}
+		pageFaults += newPageFaults;
+		contextSwitches += newContextSwitches;
+	}
+
+	lastUsage = usage;
+	isSteadyState = TRUE;
+}
+
+/**
+ * @copydoc setUpRealtimeMode
+ */
+int setUpRealtimeMode(int priority, int cpu) {
+	struct sched_param schedulingParameters = { .sched_priority = priority };
+
+	// Check if real-time mode is already set up
+	if (isRealtimeModeSetUp) {
+		return FALSE;
+	}
+
+	if (cpu != NO_CPU) {
+		cpu_set_t cpus;
+
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0) {
+			perror("sched_setaffinity()");
+			return FALSE;
+		}
+	}
+
+	// Don't give heap memory back to the system and don't use mmap() for
+	// large blocks, so freed memory stays locked
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+		perror("mlockall()");
+		return FALSE;
+	}
+	prefaultStack();
+
+	if (sched_setscheduler(0, SCHED_FIFO, &schedulingParameters) < 0) {
+		perror("sched_setscheduler()");
+		munlockall();
+		return FALSE;
+	}
+
+	isSteadyState = FALSE;
+	pageFaults = contextSwitches = 0;
+	checkTimer = setUpCallbackTimer(CHECK_INTERVAL, CHECK_INTERVAL, &checkSteadyState, NULL);
+
+	isRealtimeModeSetUp = TRUE;
+	return TRUE;
+}
+
+/**
+ * @copydoc tearDownRealtimeMode
+ */
+int tearDownRealtimeMode(void) {
+	struct sched_param schedulingParameters = { .sched_priority = 0 };
+
+	// Check if real-time mode was already torn down
+	if (!isRealtimeModeSetUp) {
+		return FALSE;
+	}
+
+	abortTimer(checkTimer);
+	checkTimer = INVALID_TIMER;
+
+	sched_setscheduler(0, SCHED_OTHER, &schedulingParameters);
+	munlockall();
+
+	printf("Real-time mode: %ld page faults and %ld involuntary context switches in steady state\n",
+			pageFaults, contextSwitches);
+
+	isRealtimeModeSetUp = FALSE;
+	return TRUE;
+}
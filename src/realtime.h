@@ -0,0 +1,39 @@
+/**
+ * Real-time mode
+ *
+ * Runs the calling thread (the event loop) with a real-time scheduling
+ * policy, locks the process memory and checks that no page faults or
+ * involuntary context switches happen in steady state.
+ *
+ * @file    realtime.h
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#ifndef REALTIME_H_
+#define REALTIME_H_
+
+/**
+ * Special case value for 'do not pin to a CPU'.
+ */
+#define NO_CPU (-1)
+
+/**
+ * Sets up the real-time mode for the calling thread.
+ * Threads inherit the scheduling policy and the CPU affinity, so it should
+ * be called after all other threads (e.g. by SDL) are started.
+ * @param priority The SCHED_FIFO priority (1 to 99).
+ * @param cpu The CPU to pin the thread to or NO_CPU.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+extern int setUpRealtimeMode(int priority, int cpu);
+
+/**
+ * Tears down the real-time mode and reports the page faults and involuntary
+ * context switches seen in steady state.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+extern int tearDownRealtimeMode(void);
+
+#endif /* REALTIME_H_ */
@@ -0,0 +1,238 @@
+/**
+ * @brief   Multiplexes the 7-segment display
+ * @version 1.0
+ * @file    segmentDisplay.c
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "defines.h"
+#include "types.h"
+#include "timebase.h"
+#include "hardwareController.h"
+#include "segmentDisplay.h"
+
+/**
+ * Segments of the glyphs (bit 0 is segment a, ..., bit 6 segment g)
+ */
+static const UINT8 digitGlyphs[10] = {
+	0x3f, 0x06, 0x5b, 0x4f, 0x66, 0x6d, 0x7d, 0x07, 0x7f, 0x6f
+};
+#define GLYPH_BLANK	0x00
+#define GLYPH_DASH	0x40
+
+/**
+ * Largest number which fits
+ */
+#define MAX_NUMBER	9999
+
+/**
+ * Time slots per refresh: one per digit and one for the LEDs
+ */
+#define NUM_OF_SLOTS	(NUM_OF_DIGITS + 1)
+
+// Segments of all digits, one byte per digit (written by the event loop,
+// read by the display thread; word sized, so the accesses are atomic)
+static volatile UINT32 shownSegments = 0;
+
+static pthread_t displayThread;
+static pthread_mutex_t displayMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t segmentsChanged = PTHREAD_COND_INITIALIZER;
+static volatile int isDisplayRunning = FALSE;
+static int isSegmentDisplaySetUp = FALSE;
+
+// Statistics, written by the display thread
+static unsigned long refreshes = 0;
+static unsigned long overruns = 0;
+static TIME maxLatency = 0;
+
+/**
+ * Reads the monotonic clock
+ */
+static TIME readClock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return SECONDS(ts.tv_sec) + NANOSECONDS(ts.tv_nsec);
+}
+
+/**
+ * The display thread
+ *
+ * Shows each digit and then the LEDs for their share of the refresh
+ * period. Sleeps while the display is off, so the port is left to the LEDs.
+ */
+static void * runSegmentDisplay(void *argument)
+{
+	TIME slot = SECONDS(1) / SEGMENT_REFRESH_RATE / NUM_OF_SLOTS;
+	TIME slotStart = readClock();
+
+	shareLedPort(TRUE);
+	while (isDisplayRunning) {
+		UINT32 segments = shownSegments;
+
+		if (!segments) {
+			// give the port back to the LEDs and wait for a number:
+			shareLedPort(FALSE);
+			pthread_mutex_lock(&displayMutex);
+			while (isDisplayRunning && !shownSegments) {
+				pthread_cond_wait(&segmentsChanged, &displayMutex);
+			}
+			pthread_mutex_unlock(&displayMutex);
+			shareLedPort(TRUE);
+			slotStart = readClock();
+			continue;
+		}
+
+		for (int i = 0; i < NUM_OF_SLOTS; i++) {
+			struct timespec wakeUpTime = {
+				.tv_sec = slotStart / SECONDS(1),
+				.tv_nsec = slotStart % SECONDS(1)
+			};
+
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeUpTime, NULL);
+			TIME latency = readClock() - slotStart;
+			if (latency > maxLatency) {
+				maxLatency = latency;
+			}
+			if (i < NUM_OF_DIGITS) {
+				writeDigit(i, (segments >> (8 * i)) & 0xff);
+			} else {
+				showLeds();
+			}
+			slotStart += slot;
+		}
+		refreshes++;
+
+		// skip the slots which were missed:
+		TIME now = readClock();
+		if (now > slotStart + slot) {
+			overruns += (now - slotStart) / slot;
+			slotStart += (now - slotStart) / slot * slot;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Hand new segments over to the display thread
+ */
+static void setSegments(UINT32 segments)
+{
+	if (segments == shownSegments) {
+		return;
+	}
+	pthread_mutex_lock(&displayMutex);
+	shownSegments = segments;
+	pthread_cond_signal(&segmentsChanged);
+	pthread_mutex_unlock(&displayMutex);
+}
+
+/**
+ * @copydoc setUpSegmentDisplay
+ */
+int setUpSegmentDisplay(void)
+{
+	if (isSegmentDisplaySetUp || !hasSegmentDisplay()) {
+		return FALSE;
+	}
+
+	shownSegments = 0;
+	refreshes = overruns = 0;
+	maxLatency = 0;
+
+	isDisplayRunning = TRUE;
+	if (pthread_create(&displayThread, NULL, &runSegmentDisplay, NULL) != 0) {
+		perror("pthread_create()");
+		isDisplayRunning = FALSE;
+		return FALSE;
+	}
+
+	isSegmentDisplaySetUp = TRUE;
+	return TRUE;
+}
+
+/**
+ * @copydoc tearDownSegmentDisplay
+ */
+int tearDownSegmentDisplay(void)
+{
+	if (!isSegmentDisplaySetUp) {
+		return FALSE;
+	}
+
+	pthread_mutex_lock(&displayMutex);
+	isDisplayRunning = FALSE;
+	pthread_cond_signal(&segmentsChanged);
+	pthread_mutex_unlock(&displayMutex);
+	pthread_join(displayThread, NULL);
+
+	for (int i = 0; i < NUM_OF_DIGITS; i++) {
+		writeDigit(i, GLYPH_BLANK);
+	}
+	shareLedPort(FALSE);
+#ifdef DEBUG
+	printf("7-segment display: %lu refreshes, %lu overruns, slot latency max %llu us\n",
+			refreshes, overruns, maxLatency / MICROSECONDS(1));
+#endif
+
+	isSegmentDisplaySetUp = FALSE;
+	return TRUE;
+}
+
+/**
+ * @copydoc setSegmentDisplayPriority
+ */
+int setSegmentDisplayPriority(int priority)
+{
+	struct sched_param schedulingParameters = { .sched_priority = priority };
+
+	if (!isSegmentDisplaySetUp) {
+		return FALSE;
+	}
+
+	if (pthread_setschedparam(displayThread, SCHED_FIFO, &schedulingParameters) != 0) {
+		printf("Unable to set 7-segment display priority!\n");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * @copydoc showSegmentNumber
+ */
+void showSegmentNumber(unsigned int number)
+{
+	UINT32 segments = 0;
+
+	// from the rightmost digit, without leading zeros:
+	for (int i = NUM_OF_DIGITS - 1; i >= 0; i--) {
+		UINT8 glyph;
+
+		if (number > MAX_NUMBER) {
+			glyph = GLYPH_DASH;
+		} else if (number || i == NUM_OF_DIGITS - 1) {
+			glyph = digitGlyphs[number % 10];
+			number /= 10;
+		} else {
+			glyph = GLYPH_BLANK;
+		}
+		segments |= (UINT32) glyph << (8 * i);
+	}
+	setSegments(segments);
+}
+
+/**
+ * @copydoc clearSegmentDisplay
+ */
+void clearSegmentDisplay(void)
+{
+	setSegments(0);
+}
@@ -0,0 +1,70 @@
+/**
+ * @brief   Multiplexes the 7-segment display
+ *
+ * The board shows one digit at a time, so a thread enables the digits one
+ * after the other at a fixed refresh rate. The thread doesn't depend on
+ * the event loop, so the digits don't flicker while the loop is busy (e.g.
+ * redrawing the display). The shown value is converted to segments once,
+ * when it is set.
+ *
+ * The digits share the port with the LEDs, so while a number is shown the
+ * LEDs get a time slot of their own after the digits (see shareLedPort()).
+ * They are lit for a fifth of the time then, and the pattern of dimmed
+ * LEDs is only sampled once per refresh.
+ *
+ * @file    segmentDisplay.h
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#ifndef SEGMENTDISPLAY_H_
+#define SEGMENTDISPLAY_H_
+
+/**
+ * Number of digits
+ */
+#define NUM_OF_DIGITS	4
+
+/**
+ * Refresh rate of the whole display in Hz
+ */
+#define SEGMENT_REFRESH_RATE	100
+
+/**
+ * Initialize the 7-segment display
+ *
+ * @return Returns TRUE if the board has a display and the thread is running
+ */
+extern int setUpSegmentDisplay(void);
+
+/**
+ * Clean up the 7-segment display
+ *
+ * @return Returns TRUE if cleaning up was successful
+ */
+extern int tearDownSegmentDisplay(void);
+
+/**
+ * Set the SCHED_FIFO priority of the multiplexing thread
+ *
+ * @param priority The priority (1 to 99)
+ * @return Returns TRUE if successful
+ */
+extern int setSegmentDisplayPriority(int priority);
+
+/**
+ * Show a number right aligned
+ *
+ * Numbers which don't fit are shown as dashes.
+ *
+ * @param number The number
+ */
+extern void showSegmentNumber(unsigned int number);
+
+/**
+ * Turn the display off
+ */
+extern void clearSegmentDisplay(void);
+
+#endif /* SEGMENTDISPLAY_H_ */
@@ -11,16 +11,9 @@
 #include "defines.h"
 #include "types.h"
 #include "hardwareController.h"
+#include "inputController.h"
 #include "sensorController.h"
 
-#ifdef CARME
- #include "carme.h"
-#elif defined(ORCHID)
- #include "orchid.h"
-#else
- #error "no board defined!"
-#endif
-
 static int isSensorControllerSetUp = FALSE;
 
 /**
@@ -67,14 +60,8 @@ enum SensorState getSensorState(int id)
 		return sensor_unknown;
 	}
 
-#ifdef CARME
-	sensors = *(volatile unsigned char *) (mmap_base + SWITCH_OFFSET);
-#elif defined(ORCHID)
-	// it is important to read twice, else the result would not be reliable
-	// (usleep for some microseconds would work as well):
-	GPIO_read_switch();
-    sensors = GPIO_read_switch();
-#endif
+	// the sensors are sampled together with the switches and buttons:
+	sensors = (UINT8) (getInputSnapshot() >> SNAPSHOT_SENSORS_SHIFT);
 
     // mask value of all sensors with sensor id to get only the status of the
     // selected sensor:
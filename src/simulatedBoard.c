@@ -0,0 +1,352 @@
+/**
+ * @brief   Simulated board
+ * @file    simulatedBoard.c
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "defines.h"
+#include "types.h"
+#include "timebase.h"
+#include "eventLoop.h"
+#include "hardwareController.h"
+#include "simulatedBoard.h"
+
+#ifdef ORCHID
+ #include "orchid.h"
+#endif
+
+/**
+ * Script commands
+ */
+enum ScriptCommand {
+	command_switchOn = 0, /**< command_switchOn  */
+	command_switchOff,    /**< command_switchOff */
+	command_buttonOn,     /**< command_buttonOn  */
+	command_buttonOff,    /**< command_buttonOff */
+	command_repeat,       /**< command_repeat    */
+	command_quit          /**< command_quit      */
+};
+
+/**
+ * A script line
+ */
+typedef struct {
+	TIME time;                   /**< Time relative to the script start */
+	enum ScriptCommand command;  /**< The command */
+	UINT8 input;                 /**< The input bit of switch and button commands */
+} ScriptEntry;
+
+static const char *scriptFileName = NULL;
+static ScriptEntry *script = NULL;
+static int scriptLength = 0;
+static int nextScriptEntry = 0;
+static TIME scriptStartTime;
+
+static UINT8 switches = 0;
+static UINT8 buttons = 0;
+static UINT8 buttonEdges = 0;
+static UINT8 leds = 0;
+static volatile UINT8 actuators = 0;
+static unsigned long ledChanges = 0;
+static unsigned long actuatorChanges = 0;
+
+#ifdef ORCHID
+/**
+ * The LEDs are written as on the ORCHID board, but to registers in memory,
+ * so the register accesses can be counted
+ */
+static UINT32 registers[MAP_SIZE / sizeof(UINT32)];
+static unsigned long ledWrites = 0;
+static unsigned long digitWrites = 0;
+static UINT8 digits[4];
+static unsigned long setUpAccesses = 0;
+#endif
+
+/**
+ * Parse a script line
+ *
+ * @param line The line
+ * @param entry The parsed line
+ * @return Returns TRUE if the line is a command, FALSE if it is empty or
+ * a comment and EOF if it is invalid
+ */
+static int parseScriptLine(char *line, ScriptEntry *entry)
+{
+	unsigned long time;
+	char command[16];
+	char state[16];
+	int input;
+
+	// strip comments:
+	if (strchr(line, '#')) {
+		*strchr(line, '#') = '\0';
+	}
+	if (sscanf(line, "%lu %15s", &time, command) < 2) {
+		return sscanf(line, "%15s", command) < 1 ? FALSE : EOF;
+	}
+	entry->time = MILLISECONDS(time);
+	entry->input = 0;
+
+	if (strcmp(command, "repeat") == 0) {
+		entry->command = command_repeat;
+		return TRUE;
+	}
+	if (strcmp(command, "quit") == 0) {
+		entry->command = command_quit;
+		return TRUE;
+	}
+
+	if (sscanf(line, "%*u %*s %d %15s", &input, state) < 2 || input < 1 || input > 8) {
+		return EOF;
+	}
+	entry->input = 1 << (input - 1);
+	if (strcmp(command, "switch") == 0) {
+		entry->command = command_switchOn;
+	} else if (strcmp(command, "button") == 0) {
+		entry->command = command_buttonOn;
+	} else {
+		return EOF;
+	}
+	// the off command follows the on command:
+	if (strcmp(state, "off") == 0) {
+		entry->command++;
+	} else if (strcmp(state, "on") != 0) {
+		return EOF;
+	}
+	return TRUE;
+}
+
+/**
+ * Load the script
+ *
+ * @return Returns TRUE if successful
+ */
+static int loadScript(void)
+{
+	char line[128];
+	int lineNumber = 0;
+	ScriptEntry entry;
+	FILE *file = fopen(scriptFileName, "r");
+
+	if (!file) {
+		printf("Cannot open script %s\n", scriptFileName);
+		return FALSE;
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		lineNumber++;
+		switch (parseScriptLine(line, &entry)) {
+		case TRUE:
+			script = realloc(script, (scriptLength + 1) * sizeof(ScriptEntry));
+			script[scriptLength++] = entry;
+			break;
+		case EOF:
+			printf("Invalid command in script %s, line %d\n", scriptFileName, lineNumber);
+			fclose(file);
+			return FALSE;
+		}
+	}
+	fclose(file);
+	return TRUE;
+}
+
+/**
+ * Execute the script commands whose time has come
+ */
+static void runScript(void)
+{
+	TIME now = getCurrentTime();
+
+	while (nextScriptEntry < scriptLength
+			&& scriptStartTime + script[nextScriptEntry].time <= now) {
+		ScriptEntry *entry = &script[nextScriptEntry++];
+
+		switch (entry->command) {
+		case command_switchOn:
+			switches |= entry->input;
+			break;
+		case command_switchOff:
+			switches &= ~entry->input;
+			break;
+		case command_buttonOn:
+			buttonEdges |= ~buttons & entry->input;
+			buttons |= entry->input;
+			break;
+		case command_buttonOff:
+			buttonEdges |= buttons & entry->input;
+			buttons &= ~entry->input;
+			break;
+		case command_repeat:
+			scriptStartTime += entry->time;
+			nextScriptEntry = 0;
+			// a repeat at time 0 would never end:
+			if (entry->time == 0) {
+				return;
+			}
+			break;
+		case command_quit:
+			stopEventLoop();
+			return;
+		}
+	}
+}
+
+/**
+ * @copydoc setSimulationScript
+ */
+void setSimulationScript(const char *fileName)
+{
+	scriptFileName = fileName;
+}
+
+/**
+ * Set up the simulated board
+ */
+static int setUpSimulatedBoard(void)
+{
+	switches = buttons = buttonEdges = leds = actuators = 0;
+	ledChanges = actuatorChanges = 0;
+#ifdef ORCHID
+	// the pins are configured from the same table as on the board:
+	mmap_base = registers;
+	ledWrites = digitWrites = 0;
+	memset(digits, 0, sizeof(digits));
+	GPIO_access_count = 0;
+	GPIO_init();
+	setUpAccesses = GPIO_access_count;
+#endif
+
+	if (scriptFileName && !loadScript()) {
+		return FALSE;
+	}
+	nextScriptEntry = 0;
+	scriptStartTime = getCurrentTime();
+	return TRUE;
+}
+
+/**
+ * Tear down the simulated board
+ */
+static int tearDownSimulatedBoard(void)
+{
+#ifdef DEBUG
+	printf("Simulated board: %lu LED changes, %lu actuator changes\n", ledChanges, actuatorChanges);
+#ifdef ORCHID
+	printf("Simulated board: %lu register accesses for the set up, %lu for %lu LED and %lu digit writes\n",
+			setUpAccesses, GPIO_access_count - setUpAccesses, ledWrites, digitWrites);
+#endif
+#endif
+#ifdef ORCHID
+	mmap_base = NULL;
+#endif
+
+	free(script);
+	script = NULL;
+	scriptLength = 0;
+	return TRUE;
+}
+
+/**
+ * Read the simulated switches
+ */
+static UINT8 readSimulatedSwitches(void)
+{
+	runScript();
+	return switches;
+}
+
+/**
+ * Read the simulated buttons
+ */
+static UINT8 readSimulatedButtons(void)
+{
+	runScript();
+	return buttons;
+}
+
+/**
+ * Read and clear the simulated button edges
+ */
+static UINT8 readSimulatedButtonEdges(void)
+{
+	UINT8 edges;
+
+	runScript();
+	edges = buttonEdges;
+	buttonEdges = 0;
+	return edges;
+}
+
+/**
+ * Set the simulated LEDs
+ */
+static void writeSimulatedLeds(UINT8 pattern)
+{
+#ifdef ORCHID
+	GPIO_write_led(pattern);
+	ledWrites++;
+#endif
+	if (pattern != leds) {
+#ifdef DEBUG
+		printf("Simulated board: LEDs 0x%02x\n", pattern);
+#endif
+		leds = pattern;
+		ledChanges++;
+	}
+}
+
+#ifdef ORCHID
+/**
+ * Show a digit of the simulated 7-segment display
+ */
+static void writeSimulatedDigit(int digit, UINT8 segments)
+{
+	GPIO_write_digit(digit, segments);
+	digitWrites++;
+	if (segments != digits[digit % 4]) {
+#ifdef DEBUG
+		printf("Simulated board: Digit %d 0x%02x\n", digit, segments);
+#endif
+		digits[digit % 4] = segments;
+	}
+}
+#endif
+
+/**
+ * Set the simulated actuators
+ */
+static void writeSimulatedActuators(UINT8 pattern)
+{
+	if (pattern != actuators) {
+#ifdef DEBUG
+		printf("Simulated board: Actuators 0x%02x\n", pattern);
+#endif
+		actuators = pattern;
+		actuatorChanges++;
+	}
+}
+
+/**
+ * @copydoc simulatedBoard
+ */
+const HardwareBackend simulatedBoard = {
+	.name = "sim",
+	.setUp = setUpSimulatedBoard,
+	.tearDown = tearDownSimulatedBoard,
+	.readSwitches = readSimulatedSwitches,
+	.readButtons = readSimulatedButtons,
+	.readButtonEdges = readSimulatedButtonEdges,
+	// the sensors are connected to the switch inputs as on the boards:
+	.readSensors = readSimulatedSwitches,
+	.writeLeds = writeSimulatedLeds,
+#ifdef ORCHID
+	.writeDigit = writeSimulatedDigit,
+#endif
+	.writeActuators = writeSimulatedActuators
+};
@@ -0,0 +1,50 @@
+/**
+ * @brief   Simulated board
+ *
+ * A hardware backend without hardware. The inputs are changed by a
+ * script, which is a text file with one command per line:
+ *
+ * @code
+ * # <time in ms> <command>
+ * 0     switch 1 on     # sets switch 1 (SWITCH_1)
+ * 1000  button 4 on     # presses button 4 (BUTTON_4)
+ * 1100  button 4 off    # releases button 4
+ * 9000  quit            # stops the application
+ * @endcode
+ *
+ * Instead of quit, the last command can be "repeat", which restarts the
+ * script (the times are relative to the restart again). Commands after a
+ * repeat are never executed.
+ *
+ * The times are relative to the start of the script and measured on the
+ * time base, so a script runs accelerated with a dilated or virtual clock.
+ * As on the boards, the sensors are connected to the switch inputs. As on
+ * the ORCHID board, the edges of the buttons are latched, so a press
+ * between two reads is not lost.
+ *
+ * @file    simulatedBoard.h
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#ifndef SIMULATEDBOARD_H_
+#define SIMULATEDBOARD_H_
+
+#include "hardwareController.h"
+
+/**
+ * The simulated board backend (named "sim")
+ */
+extern const HardwareBackend simulatedBoard;
+
+/**
+ * Set the input script of the simulated board
+ *
+ * Has to be called before the hardware controller is set up.
+ *
+ * @param fileName Name of the script file
+ */
+extern void setSimulationScript(const char *fileName);
+
+#endif /* SIMULATEDBOARD_H_ */
@@ -0,0 +1,111 @@
+/**
+ * @brief   Monotonic time base
+ * @file    timebase.c
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#include <time.h>
+#include "defines.h"
+#include "timebase.h"
+
+static enum ClockMode clockMode = clock_real;
+static unsigned int clockDilation = 1;
+static TIME systemStartTime = 0;
+static TIME startTime = 0;
+static TIME currentTime = 0;
+static int isCurrentTimeValid = FALSE;
+
+/**
+ * Read the monotonic clock of the system
+ *
+ * @return Returns the monotonic clock time
+ */
+static TIME readSystemClock(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return SECONDS(ts.tv_sec) + NANOSECONDS(ts.tv_nsec);
+}
+
+/**
+ * @copydoc setUpClock
+ */
+int setUpClock(enum ClockMode mode, unsigned int dilation) {
+	// the time must not jump once it was read:
+	if (isCurrentTimeValid) {
+		return FALSE;
+	}
+	if (mode == clock_dilated && dilation == 0) {
+		return FALSE;
+	}
+
+	clockMode = mode;
+	clockDilation = mode == clock_dilated ? dilation : 1;
+	systemStartTime = readSystemClock();
+	startTime = systemStartTime;
+	currentTime = startTime;
+	isCurrentTimeValid = TRUE;
+	return TRUE;
+}
+
+/**
+ * @copydoc isClockVirtual
+ */
+int isClockVirtual(void) {
+	return clockMode == clock_virtual;
+}
+
+/**
+ * @copydoc advanceVirtualTime
+ */
+void advanceVirtualTime(TIME time) {
+	if (clockMode == clock_virtual && time != NO_TIME && time > currentTime) {
+		currentTime = time;
+	}
+}
+
+/**
+ * @copydoc toSystemTime
+ */
+TIME toSystemTime(TIME time) {
+	if (clockMode != clock_dilated || time == NO_TIME) {
+		return time;
+	}
+	if (time <= startTime) {
+		return systemStartTime;
+	}
+	// round up, so the point in time has been reached at the system time:
+	return systemStartTime + (time - startTime + clockDilation - 1) / clockDilation;
+}
+
+/**
+ * @copydoc updateCurrentTime
+ */
+TIME updateCurrentTime(void) {
+	switch (clockMode) {
+	case clock_dilated:
+		currentTime = startTime + (readSystemClock() - systemStartTime) * clockDilation;
+		break;
+	case clock_virtual:
+		// only advanced by advanceVirtualTime()
+		break;
+	default:
+		currentTime = readSystemClock();
+		break;
+	}
+	isCurrentTimeValid = TRUE;
+	return currentTime;
+}
+
+/**
+ * @copydoc getCurrentTime
+ */
+TIME getCurrentTime(void) {
+	// the clock was not read yet:
+	if (!isCurrentTimeValid) {
+		return updateCurrentTime();
+	}
+	return currentTime;
+}
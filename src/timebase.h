@@ -0,0 +1,109 @@
+/**
+ * @brief   Monotonic time base
+ * @file    timebase.h
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+#include "types.h"
+
+/**
+ * Point in time or duration in nanoseconds.
+ * Points in time are relative to an arbitrary, but fixed epoch of the
+ * monotonic clock (CLOCK_MONOTONIC), so they are not affected by
+ * changes of the wall clock time. If the clock is dilated or virtual (see
+ * setUpClock()), the time only starts at the monotonic clock time.
+ */
+typedef UINT64 TIME;
+
+/**
+ * Special case value for 'no point in time'.
+ */
+#define NO_TIME (~(TIME) 0)
+
+/**
+ * Duration conversion macros
+ */
+#define NANOSECONDS(x)	((TIME) (x))
+#define MICROSECONDS(x)	((TIME) (x) * 1000ULL)
+#define MILLISECONDS(x)	((TIME) (x) * 1000000ULL)
+#define SECONDS(x)		((TIME) (x) * 1000000000ULL)
+
+/**
+ * Convert a duration to milliseconds
+ */
+#define TO_MILLISECONDS(x)	((x) / 1000000ULL)
+
+/**
+ * Clock modes
+ */
+enum ClockMode {
+	clock_real = 0, /**< The time is the monotonic clock */
+	clock_dilated,  /**< The time runs a fixed factor faster than the monotonic clock */
+	clock_virtual   /**< The time only advances by advanceVirtualTime() */
+};
+
+/**
+ * Set up the clock
+ *
+ * Selects the clock mode. Has to be called before the time is read for
+ * the first time.
+ *
+ * @param mode The clock mode
+ * @param dilation The factor by which the time runs faster than the
+ * monotonic clock (clock_dilated only)
+ * @return Returns TRUE if successful, otherwise FALSE
+ */
+extern int setUpClock(enum ClockMode mode, unsigned int dilation);
+
+/**
+ * Check if the clock is virtual
+ *
+ * @return Returns TRUE if the clock mode is clock_virtual
+ */
+extern int isClockVirtual(void);
+
+/**
+ * Advance the virtual time
+ *
+ * Lets the virtual time jump forward to the given point in time. Has no
+ * effect if the clock is not virtual or if the point in time has passed.
+ *
+ * @param time The point in time
+ */
+extern void advanceVirtualTime(TIME time);
+
+/**
+ * Convert a point in time to monotonic clock time
+ *
+ * @param time The point in time
+ * @return Returns the time of the monotonic clock (CLOCK_MONOTONIC) at
+ * which the given point in time is reached
+ */
+extern TIME toSystemTime(TIME time);
+
+/**
+ * Read the clock
+ *
+ * Reads the clock and updates the current time returned by
+ * getCurrentTime(). Gets called once per event loop iteration.
+ *
+ * @return Returns the current time
+ */
+extern TIME updateCurrentTime(void);
+
+/**
+ * Get the current time
+ *
+ * Returns the time of the last clock read, so it is cheap and
+ * consistent within one event loop iteration.
+ *
+ * @return Returns the current time
+ */
+extern TIME getCurrentTime(void);
+
+#endif /* TIMEBASE_H_ */
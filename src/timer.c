@@ -4,73 +4,445 @@
  * @version 1.0
  * @author  Elmar Vonlanthen (vonle1@bfh.ch)
  * @date    May 26, 2011
+ *
+ * Timers are kept in a hierarchical timing wheel with a tick of one
+ * microsecond (TICK_DURATION). Every level has
+ * WHEEL_SIZE slots, a slot on level n covers WHEEL_SIZE^n ticks. A running
+ * timer is linked into the slot of its expiry time on the lowest level whose
+ * current round contains the expiry time. When the time reaches the start
+ * of a slot on a higher level, its timers are cascaded down one or more
+ * levels. An occupancy bitmap per level allows to find the next non-empty
+ * slot without scanning.
+ *
+ * Timer descriptors are taken from a preallocated pool, so setting up and
+ * aborting a timer never allocates memory. Clients refer to a timer by a
+ * handle containing the descriptor index and generation (see TIMER).
  */
 
-#include <stdlib.h>
-#include <sys/time.h>
+#include <stdio.h>
 #include "defines.h"
+#include "types.h"
 #include "timer.h"
 
-typedef struct {
-	unsigned long startTime;
-	unsigned long endTime;
+/**
+ * Duration of one wheel tick.
+ */
+#define TICK_DURATION MICROSECONDS(1)
+/**
+ * Number of bits of a tick handled by one wheel level.
+ */
+#define WHEEL_BITS 6
+/**
+ * Number of slots per wheel level.
+ */
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+/**
+ * Number of wheel levels. Timers beyond the range of the top level
+ * (WHEEL_SIZE^WHEEL_LEVELS ticks) are kept in an overflow list.
+ */
+#define WHEEL_LEVELS 6
+/**
+ * Pseudo levels of the overflow list and of the list of elapsed timers
+ * whose handlers are about to be called.
+ */
+#define OVERFLOW_LEVEL WHEEL_LEVELS
+#define EXPIRING_LEVEL (WHEEL_LEVELS + 1)
+
+/**
+ * Special case value for 'no event'.
+ */
+#define NO_EVENT_TIME (~0ULL)
+
+/**
+ * Timer handle layout
+ */
+#define HANDLE_INDEX_BITS	16
+#define HANDLE_INDEX_MASK	((1 << HANDLE_INDEX_BITS) - 1)
+#define MAKE_HANDLE(index, generation)	(((TIMER) (generation) << HANDLE_INDEX_BITS) | (index))
+
+/**
+ * Timer descriptor states
+ */
+enum TimerState {
+	timer_free = 0, /**< timer_free    */
+	timer_running   /**< timer_running */
+};
+
+typedef struct TimerDescriptor {
+	struct TimerDescriptor *next;
+	struct TimerDescriptor *prev;
+	UINT64 endTime;
+	UINT64 period;
+	TimerCallback callback;
+	void *context;
+	UINT16 generation;
+	UINT8 state;
+	UINT8 level;
+	UINT8 slot;
 } TimerDescriptor;
 
+static TimerDescriptor timerPool[MAX_TIMERS];
+static TimerDescriptor *freeTimers = NULL;
+static int isTimerPoolInitialized = FALSE;
+
+static TimerDescriptor *wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static UINT64 occupiedSlots[WHEEL_LEVELS];
+static TimerDescriptor *overflowTimers = NULL;
+static TimerDescriptor *expiringTimers = NULL;
+static unsigned int runningTimers = 0;
+
+// The next tick which has not been processed yet:
+static UINT64 wheelTime;
+// The tick of the current time during updateTimers():
+static UINT64 currentTick;
+
+/**
+ * Initialize the timer pool and the timing wheel on first use
+ */
+static void initializeTimers(void) {
+	freeTimers = NULL;
+	for (int i = MAX_TIMERS - 1; i >= 0; i--) {
+		timerPool[i].state = timer_free;
+		// generation 0 is never used, so a valid handle is never 0:
+		timerPool[i].generation = 1;
+		timerPool[i].next = freeTimers;
+		freeTimers = &timerPool[i];
+	}
+	wheelTime = getCurrentTime() / TICK_DURATION + 1;
+	isTimerPoolInitialized = TRUE;
+}
+
+/**
+ * Link a running timer into the wheel according to its end time
+ *
+ * @param td Pointer to timer descriptor structure
+ */
+static void linkTimer(TimerDescriptor *td) {
+	TimerDescriptor **list;
+	UINT64 endTime = td->endTime;
+	int level;
+
+	// a timer which is already due will be processed with the next tick:
+	if (endTime < wheelTime) {
+		endTime = wheelTime;
+	}
+
+	// find the lowest level whose current round contains the end time:
+	for (level = 0; level < WHEEL_LEVELS; level++) {
+		if ((endTime >> (WHEEL_BITS * (level + 1)))
+			== (wheelTime >> (WHEEL_BITS * (level + 1)))) {
+			break;
+		}
+	}
+
+	td->level = level;
+	if (level < OVERFLOW_LEVEL) {
+		td->slot = (endTime >> (WHEEL_BITS * level)) & WHEEL_MASK;
+		list = &wheel[level][td->slot];
+		occupiedSlots[level] |= 1ULL << td->slot;
+	} else {
+		td->slot = 0;
+		list = &overflowTimers;
+	}
+
+	td->prev = NULL;
+	td->next = *list;
+	if (*list) {
+		(*list)->prev = td;
+	}
+	*list = td;
+}
+
+/**
+ * Unlink a running timer from the wheel
+ *
+ * @param td Pointer to timer descriptor structure
+ */
+static void unlinkTimer(TimerDescriptor *td) {
+	if (td->prev) {
+		td->prev->next = td->next;
+	} else if (td->level < OVERFLOW_LEVEL) {
+		wheel[td->level][td->slot] = td->next;
+		if (td->next == NULL) {
+			occupiedSlots[td->level] &= ~(1ULL << td->slot);
+		}
+	} else if (td->level == OVERFLOW_LEVEL) {
+		overflowTimers = td->next;
+	} else {
+		expiringTimers = td->next;
+	}
+	if (td->next) {
+		td->next->prev = td->prev;
+	}
+	td->next = td->prev = NULL;
+}
+
+/**
+ * Get the next time at which a timer elapses or timers have to be
+ * cascaded to a lower level
+ *
+ * @return Returns the time in ticks or NO_EVENT_TIME
+ */
+static UINT64 getNextEventTime(void) {
+	UINT64 nextTime = NO_EVENT_TIME;
+
+	for (int level = 0; level < WHEEL_LEVELS; level++) {
+		int shift = WHEEL_BITS * level;
+		int slot = (wheelTime >> shift) & WHEEL_MASK;
+		UINT64 pending = occupiedSlots[level] & (~0ULL << slot);
+		if (pending) {
+			UINT64 roundStart = (wheelTime >> (shift + WHEEL_BITS)) << (shift + WHEEL_BITS);
+			UINT64 slotTime = roundStart | ((UINT64) __builtin_ctzll(pending) << shift);
+			if (slotTime < nextTime) {
+				nextTime = slotTime;
+			}
+		}
+	}
+	if (overflowTimers) {
+		int shift = WHEEL_BITS * WHEEL_LEVELS;
+		UINT64 nextRound = ((wheelTime >> shift) + 1) << shift;
+		if (nextRound < nextTime) {
+			nextTime = nextRound;
+		}
+	}
+	// a slot whose start has already passed is due now:
+	if (nextTime != NO_EVENT_TIME && nextTime < wheelTime) {
+		nextTime = wheelTime;
+	}
+	return nextTime;
+}
+
+/**
+ * Cascade all timers of a list down to the lower levels
+ *
+ * @param list Pointer to the list head
+ */
+static void cascadeTimers(TimerDescriptor **list) {
+	TimerDescriptor *td = *list;
+
+	*list = NULL;
+	while (td) {
+		TimerDescriptor *next = td->next;
+		linkTimer(td);
+		td = next;
+	}
+}
+
+/**
+ * Return a timer descriptor to the pool
+ *
+ * Changes the descriptor's generation, so all handles to it become stale.
+ *
+ * @param td Pointer to timer descriptor structure
+ */
+static void releaseTimer(TimerDescriptor *td) {
+	td->state = timer_free;
+	if (++td->generation == 0) {
+		td->generation = 1;
+	}
+	td->next = freeTimers;
+	freeTimers = td;
+}
+
+/**
+ * Look up the descriptor of a running timer
+ *
+ * @param timer Timer handle
+ * @return Returns pointer to the timer descriptor structure or NULL if the
+ * handle is invalid or stale
+ */
+static TimerDescriptor *getRunningTimer(TIMER timer) {
+	unsigned int index = timer & HANDLE_INDEX_MASK;
+	TimerDescriptor *td;
+
+	if (timer == INVALID_TIMER || index >= MAX_TIMERS) {
+		return NULL;
+	}
+	td = &timerPool[index];
+	if (td->state != timer_running || td->generation != (timer >> HANDLE_INDEX_BITS)) {
+		return NULL;
+	}
+	return td;
+}
+
+/**
+ * Call the handlers of the elapsed timers
+ *
+ * One-shot timers are released and periodic timers are linked into the
+ * wheel again before their handler is called. Missed periods are skipped.
+ */
+static void dispatchElapsedTimers(void) {
+	TimerDescriptor *td;
+
+	while ((td = expiringTimers) != NULL) {
+		TimerCallback callback = td->callback;
+		void *context = td->context;
+
+		unlinkTimer(td);
+		if (td->period) {
+			td->endTime += td->period;
+			if (td->endTime <= currentTick) {
+				td->endTime += ((currentTick - td->endTime) / td->period + 1) * td->period;
+			}
+			linkTimer(td);
+		} else {
+			runningTimers--;
+			releaseTimer(td);
+		}
+
+		if (callback) {
+			(*callback)(context);
+		}
+	}
+}
+
+/**
+ * Process one tick: cascade the slots starting at this tick and move
+ * the timers of the current lowest level slot to the elapsed timers
+ *
+ * @param time The tick to process
+ */
+static void processTick(UINT64 time) {
+	int slot;
+
+	wheelTime = time;
+
+	// cascade from the top down, so timers can fall through several levels:
+	if ((time & ((1ULL << (WHEEL_BITS * WHEEL_LEVELS)) - 1)) == 0) {
+		cascadeTimers(&overflowTimers);
+	}
+	for (int level = WHEEL_LEVELS - 1; level > 0; level--) {
+		if ((time & ((1ULL << (WHEEL_BITS * level)) - 1)) == 0) {
+			slot = (time >> (WHEEL_BITS * level)) & WHEEL_MASK;
+			occupiedSlots[level] &= ~(1ULL << slot);
+			cascadeTimers(&wheel[level][slot]);
+		}
+	}
+
+	slot = time & WHEEL_MASK;
+	TimerDescriptor *td = wheel[0][slot];
+	wheel[0][slot] = NULL;
+	occupiedSlots[0] &= ~(1ULL << slot);
+	expiringTimers = td;
+	while (td) {
+		td->level = EXPIRING_LEVEL;
+		td = td->next;
+	}
+
+	wheelTime = time + 1;
+}
+
 /**
  * @copydoc setUpTimer
  */
-TIMER setUpTimer(unsigned int time) {
-	TimerDescriptor *timerDescriptor = malloc(sizeof(TimerDescriptor));
-	struct timeval tv;
+TIMER setUpTimer(TIME time) {
+	return setUpCallbackTimer(time, 0, NULL, NULL);
+}
 
+/**
+ * @copydoc setUpCallbackTimer
+ */
+TIMER setUpCallbackTimer(TIME time, TIME period, TimerCallback pCallback, void *context) {
+	TimerDescriptor *timerDescriptor;
+	UINT64 endTime;
+
+	if (!isTimerPoolInitialized) {
+		initializeTimers();
+	}
+
+	// set end time relative to the last clock read, rounded up to the
+	// next tick, so the timer never elapses early:
+	endTime = (getCurrentTime() + time + TICK_DURATION - 1) / TICK_DURATION;
+
+	// take a descriptor from the pool:
+	timerDescriptor = freeTimers;
 	if (timerDescriptor == NULL) {
-		return NULL;
+		printf("No free timer left!\n");
+		return INVALID_TIMER;
 	}
+	TIMER timer = MAKE_HANDLE(timerDescriptor - timerPool, timerDescriptor->generation);
 
-	// get current time as timeval structure:
-	gettimeofday(&tv, NULL);
+	if (endTime < wheelTime && pCallback == NULL && period == 0) {
+		// the tick of the end time is already processed, so the handle is
+		// stale (and thus elapsed) right away:
+		if (++timerDescriptor->generation == 0) {
+			timerDescriptor->generation = 1;
+		}
+		return timer;
+	}
 
-	// get time in milliseconds and save it as start time:
-	timerDescriptor->startTime = (tv.tv_sec*1000) + (tv.tv_usec/1000);
-	// set end time:
-	timerDescriptor->endTime = timerDescriptor->startTime + time;
-	// return structure:
-	return timerDescriptor;
+	freeTimers = timerDescriptor->next;
+	timerDescriptor->endTime = endTime;
+	// the period is rounded up to full ticks as well:
+	timerDescriptor->period = (period + TICK_DURATION - 1) / TICK_DURATION;
+	timerDescriptor->callback = pCallback;
+	timerDescriptor->context = context;
+	timerDescriptor->state = timer_running;
+	linkTimer(timerDescriptor);
+	runningTimers++;
+	// return handle:
+	return timer;
 }
 
 /**
  * @copydoc abortTimer
  */
 void abortTimer(TIMER timer) {
-	if (timer == NULL) {
+	TimerDescriptor *td = getRunningTimer(timer);
+
+	if (td == NULL) {
 		return;
 	}
 
-	free(timer);
+	unlinkTimer(td);
+	runningTimers--;
+	releaseTimer(td);
 }
 
 /**
  * @copydoc isTimerElapsed
  */
 int isTimerElapsed(TIMER timer) {
-	struct timeval tv;
-	unsigned long curTime;
-
-	if (timer == NULL) {
+	if (timer == INVALID_TIMER) {
 		return FALSE;
 	}
 
-	TimerDescriptor *td = timer;
+	// a timer which is not running anymore has elapsed (or was aborted):
+	return getRunningTimer(timer) == NULL;
+}
+
+/**
+ * @copydoc updateTimers
+ */
+void updateTimers(void) {
+	if (!isTimerPoolInitialized) {
+		initializeTimers();
+	}
+
+	currentTick = getCurrentTime() / TICK_DURATION;
 
-	// get current time as timeval structure:
-	gettimeofday(&tv, NULL);
+	// process all ticks up to now at which something happens:
+	while (runningTimers > 0) {
+		UINT64 nextTime = getNextEventTime();
+		if (nextTime > currentTick) {
+			break;
+		}
+		processTick(nextTime);
+		dispatchElapsedTimers();
+	}
+	if (wheelTime <= currentTick) {
+		wheelTime = currentTick + 1;
+	}
+}
 
-	// get time in milliseconds and save it as start time:
-	curTime = (tv.tv_sec*1000) + (tv.tv_usec/1000);
-	// check if timer is elapsed:
-	if (curTime >= td->endTime) {
-		free(td);
-		return TRUE;
+/**
+ * @copydoc getNextTimerDeadline
+ */
+TIME getNextTimerDeadline(void) {
+	if (runningTimers == 0) {
+		return NO_TIME;
 	}
-	return FALSE;
+
+	return getNextEventTime() * TICK_DURATION;
 }
@@ -9,35 +9,104 @@
 #ifndef TIMER_H_
 #define TIMER_H_
 
+#include "timebase.h"
+
+/**
+ * Maximum number of simultaneously running timers (at most 65535). Can be
+ * overridden at build time, e.g. -DMAX_TIMERS=16384 for the benchmark.
+ */
+#ifndef MAX_TIMERS
+ #define MAX_TIMERS 256
+#endif
+
+/**
+ * Timer handle
+ *
+ * The lower 16 bits are the index of the timer descriptor in the timer
+ * pool, the upper 16 bits are the generation of the descriptor at the time
+ * the timer was set up. A descriptor's generation changes whenever it is
+ * released, so a stale handle never refers to a reused descriptor.
+ */
+typedef UINT32 TIMER;
+
 /**
- * Void pointer as handle to the TimerDescriptor structure.
+ * Special case value for 'no timer'.
  */
-typedef void* TIMER;
+#define INVALID_TIMER ((TIMER) 0)
+
+/**
+ * A handler which will be called if a timer elapses.
+ *
+ * @param context The context pointer given when the timer was set up
+ */
+typedef void (*TimerCallback)(void *context);
 
 /**
  * Set up timer
  *
- * Starts the timer and returns timer description structure
+ * Starts the timer and returns its handle
  *
- * @param time Time in milliseconds
- * @return Returns pointer to timer description structure
+ * @param time Duration, the timer resolution is one microsecond
+ * @return Returns the timer handle or INVALID_TIMER if there is no free
+ * timer left
  */
-extern TIMER setUpTimer(unsigned int time);
+extern TIMER setUpTimer(TIME time);
 
 /**
- * Free timer descriptor structure
+ * Set up callback timer
+ *
+ * Starts a timer which calls the given handler when it elapses. The
+ * handler is called from updateTimers(), that is from the event loop.
+ * A periodic timer keeps running until it is aborted; the handler may
+ * abort it or set up new timers.
  *
- * @param timer Pointer to timer descriptor structure
- * @return Returns TRUE if freeing was successful
+ * @param time Duration until the first call
+ * @param period Period of the following calls or 0 for a one-shot timer
+ * @param pCallback The handler
+ * @param context A pointer passed to the handler
+ * @return Returns the timer handle or INVALID_TIMER if there is no free
+ * timer left
+ */
+extern TIMER setUpCallbackTimer(TIME time, TIME period, TimerCallback pCallback, void *context);
+
+/**
+ * Abort timer
+ *
+ * Stops a running timer. Aborting an invalid, elapsed or already aborted
+ * timer has no effect.
+ *
+ * @param timer Timer handle
  */
 extern void abortTimer(TIMER timer);
 
 /**
  * Check if timer is elapsed.
  *
- * @param timer Pointer Timer descriptor structure
- * @return Returns TRUE if time is elapsed and FALSE if not
+ * A timer is released as soon as it elapses, so the handle does not need to
+ * be freed. Once elapsed, the timer is reported elapsed on every call.
+ * An aborted timer is reported elapsed as well.
+ *
+ * @param timer Timer handle
+ * @return Returns TRUE if time is elapsed and FALSE if not or if the handle
+ * is INVALID_TIMER
  */
 extern int isTimerElapsed(TIMER timer);
 
+/**
+ * Update timers
+ *
+ * Marks all timers elapsed whose time has come according to the current
+ * time of the time base and calls the handlers of elapsed callback timers.
+ * Gets called once per event loop iteration.
+ */
+extern void updateTimers(void);
+
+/**
+ * Get next timer deadline
+ *
+ * @return Returns the point in time at which the timers need to be
+ * updated next, or NO_TIME if there is no running timer
+ */
+extern TIME getNextTimerDeadline(void);
+
 #endif /* TIMER_H_ */
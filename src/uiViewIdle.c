@@ -11,14 +11,30 @@
 #include "userInterface.h"
 #include "inputController.h"
 #include "ledController.h"
+#include "segmentDisplay.h"
 #include "logic.h"
 #include "timer.h"
 
+/* standby glow of the product leds */
+#define PRODUCT_STANDBY_BRIGHTNESS	(LED_FULL_BRIGHTNESS / 8)
+#define PRODUCT_FADE_TIME			MILLISECONDS(500)
+
+/**
+ * Fade a product led in to its standby brightness
+ */
+static void glowProductLed(int id) {
+	setLedBrightness(id, 0);
+	updateLed(id, led_on);
+	fadeLed(id, PRODUCT_STANDBY_BRIGHTNESS, PRODUCT_FADE_TIME);
+}
+
 /**
  * run action of idle view
  */
 static void run(void) {
 	CoffeeMakerViewModel *coffeemaker = getCoffeeMakerState();
+	const QueuedInputEvent *events;
+	int numberOfEvents = getInputEvents(&events);
 
 	/* Did someone turn the coffeemaker off? */
 	if (getSwitchState(POWER_SWITCH) == switch_off) {
@@ -28,18 +44,21 @@ static void run(void) {
 		switchOff();
 	}
 
-	/* product got selected? */
-	if (getButtonState(PRODUCT_1_BUTTON) == button_on) {
-		startMakingCoffee(0);
-	}
-	if (getButtonState(PRODUCT_2_BUTTON) == button_on) {
-		startMakingCoffee(1);
-	}
-	if (getButtonState(PRODUCT_3_BUTTON) == button_on) {
-		startMakingCoffee(2);
-	}
-	if (getButtonState(PRODUCT_4_BUTTON) == button_on) {
-		startMakingCoffee(3);
+	/* product got selected? (one order per press) */
+	for (int i = 0; i < numberOfEvents; i++) {
+		if (events[i].event != inputEvent_press) {
+			continue;
+		}
+		switch (events[i].line) {
+			case BUTTON_LINE(PRODUCT_1_BUTTON): startMakingCoffee(0);
+			break;
+			case BUTTON_LINE(PRODUCT_2_BUTTON): startMakingCoffee(1);
+			break;
+			case BUTTON_LINE(PRODUCT_3_BUTTON): startMakingCoffee(2);
+			break;
+			case BUTTON_LINE(PRODUCT_4_BUTTON): startMakingCoffee(3);
+			break;
+		}
 	}
 
 	/* Did someone use the milk selector? */
@@ -59,8 +78,6 @@ static void run(void) {
 #endif
 		}
 	}
-	/* Show the pretty lights */
-	updateAllLeds();
 }
 
 /**
@@ -120,12 +137,20 @@ static void update(void) {
 		showCoffeeSensor(FALSE);
 	}
 
+	/* show the drink counter */
+	showSegmentNumber(coffeemaker->numberOfDeliveredProducts);
 }
 
 /**
  * activate action of idle view
  */
 static void activate(void) {
+	/* Let the product Leds glow */
+	glowProductLed(PRODUCT_1_LED);
+	glowProductLed(PRODUCT_2_LED);
+	glowProductLed(PRODUCT_3_LED);
+	glowProductLed(PRODUCT_4_LED);
+
 	update();
 }
 
@@ -135,6 +160,12 @@ static void activate(void) {
 static void deactivate(void) {
 	DisplayState *displaystate = getDisplayState();
 
+	/* Turn off all product Leds */
+	updateLed(PRODUCT_1_LED, led_off);
+	updateLed(PRODUCT_2_LED, led_off);
+	updateLed(PRODUCT_3_LED, led_off);
+	updateLed(PRODUCT_4_LED, led_off);
+
 	/*Clear screen*/
 	GrClearWindow(displaystate->gWinID,GR_FALSE);
 }
@@ -11,38 +11,50 @@
 #include "userInterface.h"
 #include "inputController.h"
 #include "ledController.h"
+#include "ledSequencer.h"
 #include "logic.h"
 #include "timer.h"
 
 /* work ticks for activity visualization */
-#define RUN_INTERVAL	200
+#define RUN_INTERVAL	MILLISECONDS(200)
+
+/* warm-up chase over the product leds */
+static const LedKeyframe warmUpChaseKeyframes[] = {
+		{ 150, PRODUCT_1_LED },
+		{ 150, PRODUCT_2_LED },
+		{ 150, PRODUCT_3_LED },
+		{ 150, PRODUCT_4_LED }
+};
+static const LedAnimation warmUpChase = LED_ANIMATION(warmUpChaseKeyframes, TRUE);
 
 static TIMER initTimer;
 static int intervals = 0;
 
 /**
- * run action of init view
+ * Draws the activity visualization, gets called every RUN_INTERVAL
  */
-static void run(void) {
+static void showActivity(void *context) {
 	char initMessage[40] = "Initializing";
-	if (isTimerElapsed(initTimer)) {
-
-		/* set new timer */
-		initTimer = setUpTimer(RUN_INTERVAL);
-		if (intervals < 25) {
-			intervals++;
-		}
-		for (int i = 1; i < intervals; i++) {
-			strcat(initMessage,".");
-		}
-		DisplayState *displaystate = getDisplayState();
-
-		/* Select fonts */
-		displaystate->font = GrCreateFont((unsigned char *) FONTNAME, 14, NULL);
-		GrSetGCFont(displaystate->gContextID, displaystate->font);
-		GrText(displaystate->gWinID, displaystate->gContextID, 120, 30, initMessage, -1, GR_TFASCII | GR_TFTOP);
-		GrDestroyFont(displaystate->font);
+
+	if (intervals < 25) {
+		intervals++;
+	}
+	for (int i = 1; i < intervals; i++) {
+		strcat(initMessage,".");
 	}
+	DisplayState *displaystate = getDisplayState();
+
+	/* Select fonts */
+	displaystate->font = GrCreateFont((unsigned char *) FONTNAME, 14, NULL);
+	GrSetGCFont(displaystate->gContextID, displaystate->font);
+	GrText(displaystate->gWinID, displaystate->gContextID, 120, 30, initMessage, -1, GR_TFASCII | GR_TFTOP);
+	GrDestroyFont(displaystate->font);
+}
+
+/**
+ * run action of init view
+ */
+static void run(void) {
 	/* Did someone turn the coffeemaker off? */
 	if (getSwitchState(POWER_SWITCH) == switch_off) {
 #ifdef DEBUG
@@ -59,11 +71,14 @@ static void activate(void) {
 	/* turn of power led */
 	updateLed(POWER_LED,led_on);
 
+	/* start warm-up chase */
+	playLedAnimation(PRODUCT_LED_LAYER, &warmUpChase, PRODUCT_LEDS);
+
 	/* reset init wait intervals */
 	intervals = 0;
 
-	/* start Timer */
-	initTimer = setUpTimer(RUN_INTERVAL);
+	/* start periodic activity timer */
+	initTimer = setUpCallbackTimer(RUN_INTERVAL, RUN_INTERVAL, &showActivity, NULL);
 	DisplayState *displaystate = getDisplayState();
 	displaystate->gContextID = GrNewGC();
 
@@ -84,6 +99,13 @@ static void activate(void) {
 static void deactivate(void) {
 	DisplayState *displaystate = getDisplayState();
 
+	/* release activity timer */
+	abortTimer(initTimer);
+	initTimer = INVALID_TIMER;
+
+	/* stop warm-up chase */
+	stopLedAnimation(PRODUCT_LED_LAYER);
+
 	/*Clear screen*/
 	GrClearWindow(displaystate->gWinID,GR_FALSE);
 }
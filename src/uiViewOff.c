@@ -11,6 +11,8 @@
 #include "userInterface.h"
 #include "inputController.h"
 #include "ledController.h"
+#include "ledSequencer.h"
+#include "segmentDisplay.h"
 #include "logic.h"
 
 /**
@@ -55,10 +57,13 @@ static void activate(void) {
 	updateLed(MILK_LED,led_off);
 
 	/* turn off milk sensor led */
-	updateLed(MILK_SENSOR_LED, led_off);
+	stopLedAnimation(MILK_SENSOR_LED_LAYER);
 
 	/* turn off coffee sensor led */
-	updateLed(COFFEE_SENSOR_LED, led_off);
+	stopLedAnimation(COFFEE_SENSOR_LED_LAYER);
+
+	/* turn off 7-segment display */
+	clearSegmentDisplay();
 }
 
 /**
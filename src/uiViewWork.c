@@ -10,17 +10,86 @@
 #include "userInterface.h"
 #include "inputController.h"
 #include "ledController.h"
+#include "ledSequencer.h"
+#include "segmentDisplay.h"
 #include "logic.h"
 #include "timer.h"
 
-/* how long are we waiting until new button events register */
-#define BUTTON_DELAY	800
+/* blinking of the active product led */
+static const LedKeyframe productBlinkKeyframes[] = {
+		{ 250, 0xff },
+		{ 250, 0x00 }
+};
+static const LedAnimation productBlink = LED_ANIMATION(productBlinkKeyframes, TRUE);
 
-/* blink interval definition */
-#define PRODUCT_BLINK_TIME_ON	250
-#define PRODUCT_BLINK_TIME_OFF	250
+/* coffee delivery progress bar over the product leds */
+#define PROGRESS_STEP	TO_MILLISECONDS(DELIVERING_COFFEE_DURATION / 4)
+static const LedKeyframe coffeeProgressKeyframes[] = {
+		{ PROGRESS_STEP, PRODUCT_1_LED },
+		{ PROGRESS_STEP, PRODUCT_1_LED | PRODUCT_2_LED },
+		{ PROGRESS_STEP, PRODUCT_1_LED | PRODUCT_2_LED | PRODUCT_3_LED },
+		{ PROGRESS_STEP, PRODUCT_LEDS }
+};
+static const LedAnimation coffeeProgress = LED_ANIMATION(coffeeProgressKeyframes, FALSE);
 
-static TIMER delayTimer;
+/* end of the ongoing delivery for the remaining seconds */
+static CoffeeMakingActivity shownActivity = coffeeMakingActivity_undefined;
+static TIME deliveryEnd = NO_TIME;
+static TIMER countDownTimer = INVALID_TIMER;
+
+/**
+ * Shows the remaining seconds of the ongoing delivery
+ */
+static void showRemainingTime(void) {
+	TIME now = getCurrentTime();
+
+	if (deliveryEnd == NO_TIME) {
+		return;
+	}
+	if (now >= deliveryEnd) {
+		showSegmentNumber(0);
+	}
+	else {
+		showSegmentNumber((deliveryEnd - now + SECONDS(1) - 1) / SECONDS(1));
+	}
+}
+
+/**
+ * Counts the delivery down whenever the remaining seconds change
+ */
+static void countDown(void *context) {
+	showRemainingTime();
+
+	/* stop at zero */
+	if (getCurrentTime() >= deliveryEnd) {
+		abortTimer(countDownTimer);
+		countDownTimer = INVALID_TIMER;
+	}
+}
+
+/**
+ * Starts or stops the count down of the ongoing delivery
+ */
+static void startCountDown(TIME duration) {
+	TIME firstStep;
+
+	abortTimer(countDownTimer);
+	countDownTimer = INVALID_TIMER;
+	if (duration == NO_TIME) {
+		deliveryEnd = NO_TIME;
+		clearSegmentDisplay();
+		return;
+	}
+	deliveryEnd = getCurrentTime() + duration;
+	showRemainingTime();
+
+	/* the shown seconds change when a whole second remains */
+	firstStep = duration % SECONDS(1);
+	if (firstStep == 0) {
+		firstStep = SECONDS(1);
+	}
+	countDownTimer = setUpCallbackTimer(firstStep, SECONDS(1), &countDown, NULL);
+}
 
 /**
  * run action of work view
@@ -28,29 +97,30 @@ static TIMER delayTimer;
 static void run(void) {
 	MakeCoffeeProcessInstanceViewModel makingCoffee = getCoffeeMakingProcessInstanceViewModel();
 	int activeButton = PRODUCT_1_BUTTON;
+	const QueuedInputEvent *events;
+	int numberOfEvents = getInputEvents(&events);
 
-	/* wait a bit until we check anew for button events */
-	if ((delayTimer == NULL) || (isTimerElapsed(delayTimer))) {
-		/*make sure we don't use timer again */
-		delayTimer = NULL;
-
-		/* let's get the right button to query for stopping */
-		switch ( makingCoffee.productIndex ) {
-			case 0: activeButton = PRODUCT_1_BUTTON;
-			break;
-			case 1: activeButton = PRODUCT_2_BUTTON;
-			break;
-			case 2: activeButton = PRODUCT_3_BUTTON;
-			break;
-			case 3: activeButton = PRODUCT_4_BUTTON;
-			break;
-			default: activeButton = PRODUCT_1_BUTTON;
-			break;
-		}
+	/* let's get the right button to query for stopping */
+	switch ( makingCoffee.productIndex ) {
+		case 0: activeButton = PRODUCT_1_BUTTON;
+		break;
+		case 1: activeButton = PRODUCT_2_BUTTON;
+		break;
+		case 2: activeButton = PRODUCT_3_BUTTON;
+		break;
+		case 3: activeButton = PRODUCT_4_BUTTON;
+		break;
+		default: activeButton = PRODUCT_1_BUTTON;
+		break;
+	}
 
-		/* user tries to stop making coffee? */
-		if (getButtonState(activeButton) == button_on) {
+	/* user tries to stop making coffee? (only a new press, not the one
+	 * which started it) */
+	for (int i = 0; i < numberOfEvents; i++) {
+		if (events[i].line == BUTTON_LINE(activeButton)
+				&& events[i].event == inputEvent_press) {
 			abortMakingCoffee();
+			break;
 		}
 	}
 
@@ -62,8 +132,6 @@ static void run(void) {
 		switchOff();
 	}
 
-	/* update blinking Leds */
-	updateAllLeds();
 }
 
 /**
@@ -102,6 +170,28 @@ static void update(void) {
 		currentActivityIndex = 2;
 	}
 
+	/* a new delivery starts its count down */
+	if (currentActivity != shownActivity) {
+		shownActivity = currentActivity;
+		if (currentActivity == coffeeMakingActivity_deliveringMilk) {
+			startCountDown(DELIVERING_MILK_DURATION);
+		}
+		else if (currentActivity == coffeeMakingActivity_deliveringCoffee) {
+			startCountDown(DELIVERING_COFFEE_DURATION);
+		}
+		else {
+			startCountDown(NO_TIME);
+		}
+	}
+
+	/* show the progress of the coffee delivery */
+	if (currentActivity == coffeeMakingActivity_deliveringCoffee) {
+		playLedAnimation(PRODUCT_LED_LAYER, &coffeeProgress, PRODUCT_LEDS);
+	}
+	else {
+		stopLedAnimation(PRODUCT_LED_LAYER);
+	}
+
 	/* Back- Foreground color related stuff */
 	GrSetGCForeground(displaystate->gContextID, YELLOW);
 	GrSetGCUseBackground(displaystate->gContextID, GR_FALSE);
@@ -151,12 +241,12 @@ static void update(void) {
  * activate action of work view
  */
 static void activate(void) {
-	/*start Timer for button release delay*/
-	delayTimer = setUpTimer(BUTTON_DELAY);
+	/* no delivery yet */
+	shownActivity = coffeeMakingActivity_undefined;
+	startCountDown(NO_TIME);
 
 	/* start blinking led for product */
-	setBlinkingFreq(getActiveProductLedId(), PRODUCT_BLINK_TIME_ON, PRODUCT_BLINK_TIME_OFF);
-	updateLed(getActiveProductLedId(), led_blinking);
+	playLedAnimation(ACTIVE_PRODUCT_LED_LAYER, &productBlink, getActiveProductLedId());
 
 	/* update display */
 	update();
@@ -169,10 +259,12 @@ static void deactivate(void) {
 	DisplayState *displaystate = getDisplayState();
 
 	/* Turn off all product Leds */
-	updateLed(PRODUCT_1_LED, led_off);
-	updateLed(PRODUCT_2_LED, led_off);
-	updateLed(PRODUCT_3_LED, led_off);
-	updateLed(PRODUCT_4_LED, led_off);
+	stopLedAnimation(ACTIVE_PRODUCT_LED_LAYER);
+	stopLedAnimation(PRODUCT_LED_LAYER);
+
+	/* stop the count down */
+	abortTimer(countDownTimer);
+	countDownTimer = INVALID_TIMER;
 
 	/*Clear screen*/
 	GrClearWindow(displaystate->gWinID,GR_FALSE);
@@ -19,6 +19,7 @@
 #include "uiViewWork.h"
 #include "logic.h"
 #include "ledController.h"
+#include "ledSequencer.h"
 
 
 /* Current state of display with handles and elements */
@@ -30,6 +31,14 @@ static CoffeeMakerViewModel coffeemaker;
 /* CoffeMaker state after a change */
 static CoffeeMakerViewModel newCoffeeMaker;
 
+/* Sensor warning: three short pulses, then a pause */
+static const LedKeyframe errorPulseKeyframes[] = {
+		{ 100, 0xff }, { 100, 0x00 },
+		{ 100, 0xff }, { 100, 0x00 },
+		{ 100, 0xff }, { 1500, 0x00 }
+};
+static const LedAnimation errorPulse = LED_ANIMATION(errorPulseKeyframes, TRUE);
+
 /* Text labels for the product buttons according to hardware */
 static char *buttonLabels[4] = {
 		PRODUCT_1_BUTTON_TEXT,
@@ -318,13 +327,11 @@ void showMilkSensor(int state) {
 		GrText(displaystate.gWinID, displaystate.gMilkSensorID, 230, 80, "Milk empty!", -1, GR_TFASCII | GR_TFTOP);
 		GrDestroyFont(displaystate.font);
 
-		/* start blinking led for product */
-		setBlinkingFreq(MILK_SENSOR_LED, WARNING_BLINK_TIME_ON, WARNING_BLINK_TIME_OFF);
-
-		updateLed(MILK_SENSOR_LED, led_blinking);
+		/* pulse the sensor led */
+		playLedAnimation(MILK_SENSOR_LED_LAYER, &errorPulse, MILK_SENSOR_LED);
 	}
 	else {
-		updateLed(MILK_SENSOR_LED, led_off);
+		stopLedAnimation(MILK_SENSOR_LED_LAYER);
 	}
 }
 
@@ -344,12 +351,11 @@ void showCoffeeSensor(int state) {
 		GrText(displaystate.gWinID, displaystate.gCoffeeSensorID, 230, 100, "Coffee empty!", -1, GR_TFASCII | GR_TFTOP);
 		GrDestroyFont(displaystate.font);
 
-		/* start blinking led for product */
-		setBlinkingFreq(COFFEE_SENSOR_LED, WARNING_BLINK_TIME_ON, WARNING_BLINK_TIME_OFF);
-		updateLed(COFFEE_SENSOR_LED, led_blinking);
+		/* pulse the sensor led */
+		playLedAnimation(COFFEE_SENSOR_LED_LAYER, &errorPulse, COFFEE_SENSOR_LED);
 	}
 	else {
-		updateLed(COFFEE_SENSOR_LED, led_off);
+		stopLedAnimation(COFFEE_SENSOR_LED_LAYER);
 	}
 }
 
@@ -65,13 +65,19 @@
 /* maximum numbers of products able to display */
 #define MAX_PRODUCTS 4
 
-/* define warning blink interval */
-#define WARNING_BLINK_TIME_ON	1000
-#define WARNING_BLINK_TIME_OFF	2000
+/* led animation layers, a higher layer covers the lower ones */
+#define PRODUCT_LED_LAYER			0
+#define ACTIVE_PRODUCT_LED_LAYER	1
+#define MILK_SENSOR_LED_LAYER		2
+#define COFFEE_SENSOR_LED_LAYER		3
+
+/* all product leds */
+#define PRODUCT_LEDS	(PRODUCT_1_LED | PRODUCT_2_LED | PRODUCT_3_LED | PRODUCT_4_LED)
 
 #define MWINCLUDECOLORS
 #include "nano-X.h"
 #include "model.h"
+#include "timebase.h"
 
 /**
  * data type for a void function
@@ -0,0 +1,207 @@
+/**
+ * @file   watchdog.c
+ * @author agent (agent@local)
+ * @date   Oct 17, 2026
+ * @brief  Contains the stall watchdog.
+ *
+ * The event loop increments a heartbeat counter once per iteration and
+ * marks the phase it is executing. The watchdog thread samples both four
+ * times per threshold. If the heartbeat did not change while the loop was
+ * not sleeping for longer than the threshold, the loop is stalled: The
+ * machine is forced safe and the stall is logged together with the phase.
+ * As soon as the loop makes progress again, the stall duration is logged.
+ * Durations are measured on the monotonic clock (not the possibly virtual
+ * time base) with a resolution of a sampling interval.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "defines.h"
+#include "types.h"
+#include "timebase.h"
+#include "machineController.h"
+#include "watchdog.h"
+
+/**
+ * Number of samples per threshold.
+ */
+#define SAMPLES_PER_THRESHOLD 4
+
+static const char *phaseNames[NUM_OF_WATCHDOG_PHASES] = {
+	"sleeping",
+	"timers",
+	"event sources",
+	"user interface",
+	"business logic",
+	"inputs",
+	"sound"
+};
+
+// Written by the event loop, read by the watchdog thread (word sized, so
+// the accesses are atomic)
+static volatile UINT32 heartbeat = 0;
+static volatile enum WatchdogPhase currentPhase = watchdogPhase_sleeping;
+
+static pthread_t watchdogThread;
+static volatile int isWatchdogRunning = FALSE;
+static TIME stallThreshold;
+static unsigned int stalls[NUM_OF_WATCHDOG_PHASES];
+static TIME longestStall = 0;
+static int isWatchdogSetUp = FALSE;
+
+/**
+ * Reads the monotonic clock.
+ */
+static TIME readClock(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return SECONDS(ts.tv_sec) + NANOSECONDS(ts.tv_nsec);
+}
+
+/**
+ * The watchdog thread.
+ */
+static void * runWatchdog(void *argument) {
+	TIME sampleInterval = stallThreshold / SAMPLES_PER_THRESHOLD;
+	struct timespec sleepTime = {
+		.tv_sec = sampleInterval / SECONDS(1),
+		.tv_nsec = sampleInterval % SECONDS(1)
+	};
+	UINT32 lastHeartbeat = heartbeat;
+	TIME lastProgressTime = readClock();
+	enum WatchdogPhase stalledPhase = watchdogPhase_sleeping;
+	int isStalled = FALSE;
+
+	while (isWatchdogRunning) {
+		clock_nanosleep(CLOCK_MONOTONIC, 0, &sleepTime, NULL);
+
+		UINT32 sampledHeartbeat = heartbeat;
+		enum WatchdogPhase sampledPhase = currentPhase;
+		TIME now = readClock();
+
+		// A sleeping loop is not stalled
+		if (sampledHeartbeat != lastHeartbeat || sampledPhase == watchdogPhase_sleeping) {
+			if (isStalled) {
+				TIME duration = now - lastProgressTime;
+
+				printf("Watchdog: Event loop was stalled in phase '%s' for %llu ms\n",
+						phaseNames[stalledPhase], TO_MILLISECONDS(duration));
+				if (duration > longestStall) {
+					longestStall = duration;
+				}
+				isStalled = FALSE;
+			}
+			lastHeartbeat = sampledHeartbeat;
+			lastProgressTime = now;
+			continue;
+		}
+
+		if (!isStalled && now - lastProgressTime >= stallThreshold) {
+			isStalled = TRUE;
+			stalledPhase = sampledPhase;
+			stalls[stalledPhase]++;
+
+			forceMachineSafe();
+			printf("Watchdog: Event loop stalled in phase '%s', machine forced safe!\n",
+					phaseNames[stalledPhase]);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @copydoc setUpWatchdog
+ */
+int setUpWatchdog(TIME threshold) {
+	// Check if watchdog is already set up
+	if (isWatchdogSetUp) {
+		return FALSE;
+	}
+	if (threshold < SAMPLES_PER_THRESHOLD) {
+		return FALSE;
+	}
+
+	stallThreshold = threshold;
+	for (int i = 0; i < NUM_OF_WATCHDOG_PHASES; i++) {
+		stalls[i] = 0;
+	}
+	longestStall = 0;
+
+	isWatchdogRunning = TRUE;
+	if (pthread_create(&watchdogThread, NULL, &runWatchdog, NULL) != 0) {
+		perror("pthread_create()");
+		isWatchdogRunning = FALSE;
+		return FALSE;
+	}
+
+	isWatchdogSetUp = TRUE;
+	return TRUE;
+}
+
+/**
+ * @copydoc tearDownWatchdog
+ */
+int tearDownWatchdog(void) {
+	// Check if watchdog was already torn down
+	if (!isWatchdogSetUp) {
+		return FALSE;
+	}
+
+	isWatchdogRunning = FALSE;
+	pthread_join(watchdogThread, NULL);
+
+#ifdef DEBUG
+	unsigned int numberOfStalls = 0;
+	for (int i = 0; i < NUM_OF_WATCHDOG_PHASES; i++) {
+		numberOfStalls += stalls[i];
+	}
+	printf("Watchdog: %u stalls, longest %llu ms\n", numberOfStalls, TO_MILLISECONDS(longestStall));
+	for (int i = 0; i < NUM_OF_WATCHDOG_PHASES; i++) {
+		if (stalls[i]) {
+			printf("Watchdog: %u stalls in phase '%s'\n", stalls[i], phaseNames[i]);
+		}
+	}
+#endif
+
+	isWatchdogSetUp = FALSE;
+	return TRUE;
+}
+
+/**
+ * @copydoc setWatchdogPriority
+ */
+int setWatchdogPriority(int priority) {
+	struct sched_param schedulingParameters = { .sched_priority = priority };
+
+	if (!isWatchdogSetUp) {
+		return FALSE;
+	}
+
+	if (pthread_setschedparam(watchdogThread, SCHED_FIFO, &schedulingParameters) != 0) {
+		printf("Unable to set watchdog priority!\n");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * @copydoc feedWatchdog
+ */
+void feedWatchdog(void) {
+	heartbeat++;
+}
+
+/**
+ * @copydoc setWatchdogPhase
+ */
+enum WatchdogPhase setWatchdogPhase(enum WatchdogPhase phase) {
+	enum WatchdogPhase previousPhase = currentPhase;
+
+	currentPhase = phase;
+	return previousPhase;
+}
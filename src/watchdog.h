@@ -0,0 +1,71 @@
+/**
+ * Stall watchdog
+ *
+ * Watches the event loop from a separate thread. If the loop does not
+ * make progress for longer than a threshold, the watchdog forces the
+ * machine into a safe state and logs where the loop was stalled and for
+ * how long.
+ *
+ * @file    watchdog.h
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+#include "timebase.h"
+
+/**
+ * Phases of the event loop
+ *
+ * Each subsystem marks the phase it is executing, so a stall can be
+ * attributed to it.
+ */
+enum WatchdogPhase {
+	watchdogPhase_sleeping = 0,  /**< Waiting for events, not watched */
+	watchdogPhase_timers,        /**< Updating timers and calling timer handlers */
+	watchdogPhase_eventSources,  /**< Calling file descriptor handlers */
+	watchdogPhase_userInterface, /**< Running the user interface */
+	watchdogPhase_businessLogic, /**< Running the business logic */
+	watchdogPhase_inputs,        /**< Reading buttons */
+	watchdogPhase_sound,         /**< Loading and playing sound files */
+	NUM_OF_WATCHDOG_PHASES
+};
+
+/**
+ * Starts the watchdog thread.
+ * @param threshold The time after which a loop without progress is stalled.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+extern int setUpWatchdog(TIME threshold);
+
+/**
+ * Stops the watchdog thread and prints the stall statistics.
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+extern int tearDownWatchdog(void);
+
+/**
+ * Sets the SCHED_FIFO priority of the watchdog thread.
+ * It must be higher than the priority of a real-time event loop.
+ * @param priority The priority (1 to 99).
+ * @return Returns TRUE if successful, otherwise FALSE.
+ */
+extern int setWatchdogPriority(int priority);
+
+/**
+ * Signals progress of the event loop.
+ * Gets called once per event loop iteration.
+ */
+extern void feedWatchdog(void);
+
+/**
+ * Marks the phase the event loop is executing.
+ * @param phase The phase.
+ * @return Returns the previous phase, so it can be restored.
+ */
+extern enum WatchdogPhase setWatchdogPhase(enum WatchdogPhase phase);
+
+#endif /* WATCHDOG_H_ */
@@ -0,0 +1,340 @@
+/**
+ * @brief   Test of the GPIO character device buttons without a GPIO chip
+ * @file    gpioChardevTest.c
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ *
+ * Stands in for a GPIO chip, so gpioChardev.c can be tested on any host:
+ * ioctl() is wrapped (see the Makefile). The line request is answered with
+ * a pipe, into which the test writes the edge events, and the line values
+ * are taken from the simulated levels of the lines. The event loop and the
+ * loop statistics are replaced as well, the test calls the edge handler
+ * like the event loop does when the request is readable.
+ *
+ * The lines are requested in a different order than their offsets, so the
+ * mapping of the offsets to the button bits is checked.
+ *
+ * Usage: yacm_gpio_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+#include "defines.h"
+#include "types.h"
+#include "timebase.h"
+#include "eventLoop.h"
+#include "loopStatistics.h"
+#include "inputController.h"
+#include "gpioChardev.h"
+
+/**
+ * A file which stands in for the chip device (any file can be opened)
+ */
+#define CHIP_NAME	"/dev/null"
+
+/**
+ * Number of lines of the simulated chip
+ */
+#define NUM_OF_CHIP_LINES	16
+
+/**
+ * Size of the event buffer of the edge handler
+ */
+#define HANDLER_EVENTS	16
+
+// The simulated chip
+static int lineLevels[NUM_OF_CHIP_LINES];
+static struct gpio_v2_line_request lastRequest;
+static int requestFD = -1;
+static int eventFD = -1;
+static unsigned long valueReads = 0;
+
+// The replaced event loop and loop statistics
+static int eventSourceFD = -1;
+static HandleEvent eventHandler = NULL;
+static unsigned long latencies = 0;
+static TIME maxLatency = 0;
+
+static int checks = 0;
+
+extern int __real_ioctl(int fd, unsigned long request, ...);
+
+/**
+ * Report a failed check and stop the test
+ *
+ * @param message What went wrong
+ */
+static void fail(const char *message)
+{
+	printf("GPIO character device test failed: %s\n", message);
+	exit(1);
+}
+
+/**
+ * Check a condition
+ *
+ * @param condition Has to be TRUE
+ * @param message What went wrong if not
+ */
+static void check(int condition, const char *message)
+{
+	if (!condition) {
+		fail(message);
+	}
+	checks++;
+}
+
+/**
+ * Reads the monotonic clock (the clock of the edge timestamps)
+ */
+static TIME readClock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return SECONDS(ts.tv_sec) + NANOSECONDS(ts.tv_nsec);
+}
+
+/**
+ * The simulated chip: requests lines and reads their values
+ */
+int __wrap_ioctl(int fd, unsigned long request, ...)
+{
+	va_list arguments;
+	void *argument;
+
+	va_start(arguments, request);
+	argument = va_arg(arguments, void *);
+	va_end(arguments);
+
+	if (request == GPIO_V2_GET_LINE_IOCTL) {
+		struct gpio_v2_line_request *lineRequest = argument;
+		int pipeFDs[2];
+
+		for (int i = 0; i < lineRequest->num_lines; i++) {
+			if (lineRequest->offsets[i] >= NUM_OF_CHIP_LINES) {
+				return -1;
+			}
+		}
+		if (pipe(pipeFDs) < 0) {
+			return -1;
+		}
+		lastRequest = *lineRequest;
+		requestFD = lineRequest->fd = pipeFDs[0];
+		eventFD = pipeFDs[1];
+		return 0;
+	}
+	if (request == GPIO_V2_LINE_GET_VALUES_IOCTL && fd == requestFD) {
+		struct gpio_v2_line_values *values = argument;
+
+		// the bits are in the order of the requested lines:
+		values->bits = 0;
+		for (int i = 0; i < lastRequest.num_lines; i++) {
+			if ((values->mask & (1ULL << i)) && lineLevels[lastRequest.offsets[i]]) {
+				values->bits |= 1ULL << i;
+			}
+		}
+		valueReads++;
+		return 0;
+	}
+	return __real_ioctl(fd, request, argument);
+}
+
+/**
+ * @copydoc addEventSource
+ */
+int addEventSource(int fd, HandleEvent pHandler)
+{
+	eventSourceFD = fd;
+	eventHandler = pHandler;
+	return TRUE;
+}
+
+/**
+ * @copydoc removeEventSource
+ */
+int removeEventSource(int fd)
+{
+	if (fd != eventSourceFD) {
+		return FALSE;
+	}
+	eventSourceFD = -1;
+	eventHandler = NULL;
+	return TRUE;
+}
+
+/**
+ * @copydoc recordLoopStatistic
+ */
+void recordLoopStatistic(enum LoopStatistic statistic, TIME value)
+{
+	if (statistic == loopStatistic_inputLatency) {
+		latencies++;
+		if (value > maxLatency) {
+			maxLatency = value;
+		}
+	}
+}
+
+/**
+ * Let the simulated chip report an edge of a line
+ *
+ * @param offset Offset of the line
+ * @param level The new level
+ * @param time Kernel timestamp of the edge
+ */
+static void writeEdge(unsigned int offset, int level, TIME time)
+{
+	struct gpio_v2_line_event event;
+
+	memset(&event, 0, sizeof(event));
+	event.timestamp_ns = time;
+	event.id = level ? GPIO_V2_LINE_EVENT_RISING_EDGE : GPIO_V2_LINE_EVENT_FALLING_EDGE;
+	event.offset = offset;
+	lineLevels[offset] = level;
+	if (write(eventFD, &event, sizeof(event)) != sizeof(event)) {
+		fail("edge event not written");
+	}
+}
+
+/**
+ * Call the edge handler like the event loop does while the request is
+ * readable
+ */
+static void handleEdges(void)
+{
+	for (int i = 0; i < 8; i++) {
+		eventHandler(eventSourceFD);
+	}
+}
+
+/**
+ * Parse the chip and the line offsets
+ */
+static void testLineParsing(void)
+{
+	check(!setGPIOButtonLines("/dev/gpiochip0"), "lines without offsets accepted");
+	check(!setGPIOButtonLines("/dev/gpiochip0:1,2,3"), "three offsets accepted");
+	check(!setGPIOButtonLines("/dev/gpiochip0:a,b,c,d"), "bad offsets accepted");
+	check(setGPIOButtonLines("/dev/nonexistent:0,1,2,3"), "valid lines rejected");
+	check(!setUpGPIOButtons(), "missing chip accepted");
+	check(eventHandler == NULL, "event source added for a missing chip");
+
+	// BUTTON_1 to BUTTON_4 on the lines 5, 3, 7 and 1:
+	check(setGPIOButtonLines(CHIP_NAME ":5,3,7,1"), "valid lines rejected");
+}
+
+/**
+ * Request the lines
+ */
+static void testSetUp(void)
+{
+	const unsigned int offsets[] = { 5, 3, 7, 1 };
+
+	check(setUpGPIOButtons(), "set up failed");
+	check(lastRequest.num_lines == 4, "not all lines requested at once");
+	check(memcmp(lastRequest.offsets, offsets, sizeof(offsets)) == 0, "wrong line offsets requested");
+	check(lastRequest.config.flags == (GPIO_V2_LINE_FLAG_INPUT
+			| GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING),
+			"lines not requested as inputs with both edges");
+	check(strcmp(lastRequest.consumer, "yacm") == 0, "wrong consumer");
+	check(eventSourceFD == requestFD && eventHandler != NULL, "request not watched by the event loop");
+	check(fcntl(requestFD, F_GETFL) & O_NONBLOCK, "request not non-blocking");
+}
+
+/**
+ * Read the levels of the lines
+ */
+static void testLevels(void)
+{
+	const struct {
+		unsigned int offset;
+		UINT8 button;
+	} lines[] = { { 5, BUTTON_1 }, { 3, BUTTON_2 }, { 7, BUTTON_3 }, { 1, BUTTON_4 } };
+
+	check(readGPIOChardevButtons() == 0, "buttons pressed at start");
+
+	// each line alone, and a line which is not requested:
+	for (int i = 0; i < 4; i++) {
+		lineLevels[lines[i].offset] = 1;
+		check(readGPIOChardevButtons() == lines[i].button, "line mapped to the wrong button");
+		lineLevels[lines[i].offset] = 0;
+	}
+	lineLevels[0] = lineLevels[2] = 1;
+	check(readGPIOChardevButtons() == 0, "line which is not requested read");
+	lineLevels[0] = lineLevels[2] = 0;
+
+	lineLevels[5] = lineLevels[1] = 1;
+	check(readGPIOChardevButtons() == (BUTTON_1 | BUTTON_4), "two buttons read wrong");
+	lineLevels[5] = lineLevels[1] = 0;
+}
+
+/**
+ * Latch the edges of the lines
+ */
+static void testEdges(void)
+{
+	TIME now = readClock();
+	unsigned long before = latencies;
+
+	check(readGPIOChardevButtonEdges() == 0, "edges at start");
+
+	// a press shorter than a polling interval:
+	writeEdge(3, 1, now - MILLISECONDS(5));
+	writeEdge(3, 0, now - MILLISECONDS(4));
+	writeEdge(1, 1, now - MILLISECONDS(1));
+	writeEdge(2, 1, now);
+	handleEdges();
+	check(readGPIOChardevButtons() == BUTTON_4, "levels after the edges wrong");
+	check(readGPIOChardevButtonEdges() == (BUTTON_2 | BUTTON_4), "edges mapped to the wrong buttons");
+	check(latencies == before + 2, "edge latency not recorded per button");
+	// the latency is taken from the first edge of a button:
+	check(maxLatency >= MILLISECONDS(5) && maxLatency < SECONDS(1), "latency not from the first edge");
+	check(readGPIOChardevButtonEdges() == 0, "edges not cleared by the read");
+
+	// more events than the handler reads at once:
+	for (int i = 0; i <= HANDLER_EVENTS + 4; i++) {
+		writeEdge(1, i % 2 == 0, readClock());
+	}
+	writeEdge(7, 1, readClock());
+	handleEdges();
+	check(readGPIOChardevButtonEdges() == (BUTTON_3 | BUTTON_4), "edges after a full buffer lost");
+	check(readGPIOChardevButtons() == (BUTTON_3 | BUTTON_4), "levels after a full buffer wrong");
+}
+
+/**
+ * Release the lines
+ */
+static void testTearDown(void)
+{
+	int fd = requestFD;
+
+	check(tearDownGPIOButtons(), "tear down failed");
+	check(eventHandler == NULL, "request still watched by the event loop");
+	check(fcntl(fd, F_GETFD) < 0, "request not closed");
+	check(!tearDownGPIOButtons(), "torn down twice");
+}
+
+/**
+ * Run the test
+ */
+int main(int argc, char **argv)
+{
+	testLineParsing();
+	testSetUp();
+	testLevels();
+	testEdges();
+	testTearDown();
+
+	printf("GPIO character device test passed: %d checks, %lu value reads, %lu edge latencies\n",
+			checks, valueReads, latencies);
+	return 0;
+}
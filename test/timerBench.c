@@ -0,0 +1,272 @@
+/**
+ * @brief   Compares the timing wheel with the malloc based timers
+ * @file    timerBench.c
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ *
+ * Keeps a number of timers with random timeouts running and re-arms every
+ * timer when it elapses, like the clients of the timers do. The malloc
+ * based timers are polled by each client, every poll reads the wall clock.
+ * The timing wheel is updated once per iteration, the clients either poll
+ * their handles or get called back. The iterations don't sleep, so the
+ * iteration time is the CPU cost of one loop over all timers.
+ *
+ * Usage: yacm_bench [number of timers] [seconds per run]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "defines.h"
+#include "types.h"
+#include "timebase.h"
+#include "timer.h"
+#include "timerMalloc.h"
+
+/**
+ * Defaults of the command line arguments
+ */
+#define DEFAULT_NUM_OF_TIMERS	10000
+#define DEFAULT_RUN_DURATION	2
+
+/**
+ * Range of the random timeouts in ms
+ */
+#define MIN_TIMEOUT	1
+#define MAX_TIMEOUT	100
+
+/**
+ * Number of times all timers are armed and cancelled
+ */
+#define ARM_ROUNDS	20
+
+typedef struct {
+	const char *name;
+	TIME armTime;              /**< Time per arm */
+	TIME cancelTime;           /**< Time per cancel */
+	TIME runTime;              /**< Duration of the run */
+	unsigned long iterations;  /**< Iterations during the run */
+	unsigned long expirations; /**< Elapsed timers during the run */
+} BenchResult;
+
+static int numberOfTimers = DEFAULT_NUM_OF_TIMERS;
+static int runDuration = DEFAULT_RUN_DURATION;
+
+static MALLOC_TIMER mallocTimers[MAX_TIMERS];
+static TIMER timers[MAX_TIMERS];
+static unsigned long callbackExpirations;
+
+static unsigned int randomSeed;
+
+/**
+ * Get a random timeout (the same sequence for every implementation)
+ *
+ * @return Returns the timeout in ms
+ */
+static unsigned int getRandomTimeout(void)
+{
+	randomSeed = randomSeed * 1103515245 + 12345;
+	return MIN_TIMEOUT + (randomSeed >> 16) % (MAX_TIMEOUT - MIN_TIMEOUT + 1);
+}
+
+/**
+ * Reads the monotonic clock
+ */
+static TIME readClock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return SECONDS(ts.tv_sec) + NANOSECONDS(ts.tv_nsec);
+}
+
+/**
+ * Benchmark the malloc based timers
+ */
+static void benchMallocTimers(BenchResult *result)
+{
+	TIME startTime, endTime;
+
+	randomSeed = 1;
+	for (int round = 0; round < ARM_ROUNDS; round++) {
+		startTime = readClock();
+		for (int i = 0; i < numberOfTimers; i++) {
+			mallocTimers[i] = setUpMallocTimer(getRandomTimeout());
+		}
+		result->armTime += readClock() - startTime;
+
+		startTime = readClock();
+		for (int i = 0; i < numberOfTimers; i++) {
+			abortMallocTimer(mallocTimers[i]);
+		}
+		result->cancelTime += readClock() - startTime;
+	}
+
+	for (int i = 0; i < numberOfTimers; i++) {
+		mallocTimers[i] = setUpMallocTimer(getRandomTimeout());
+	}
+	startTime = readClock();
+	endTime = startTime + SECONDS(runDuration);
+	do {
+		for (int i = 0; i < numberOfTimers; i++) {
+			if (isMallocTimerElapsed(mallocTimers[i])) {
+				mallocTimers[i] = setUpMallocTimer(getRandomTimeout());
+				result->expirations++;
+			}
+		}
+		result->iterations++;
+	} while (readClock() < endTime);
+	result->runTime = readClock() - startTime;
+
+	for (int i = 0; i < numberOfTimers; i++) {
+		abortMallocTimer(mallocTimers[i]);
+	}
+}
+
+/**
+ * Arm and cancel all timers of the timing wheel
+ */
+static void benchWheelArmAndCancel(BenchResult *result)
+{
+	TIME startTime;
+
+	randomSeed = 1;
+	for (int round = 0; round < ARM_ROUNDS; round++) {
+		updateCurrentTime();
+		startTime = readClock();
+		for (int i = 0; i < numberOfTimers; i++) {
+			timers[i] = setUpTimer(MILLISECONDS(getRandomTimeout()));
+		}
+		result->armTime += readClock() - startTime;
+
+		startTime = readClock();
+		for (int i = 0; i < numberOfTimers; i++) {
+			abortTimer(timers[i]);
+		}
+		result->cancelTime += readClock() - startTime;
+	}
+}
+
+/**
+ * Benchmark the timing wheel with polled handles
+ */
+static void benchWheelTimers(BenchResult *result)
+{
+	TIME startTime, endTime;
+
+	benchWheelArmAndCancel(result);
+
+	updateCurrentTime();
+	for (int i = 0; i < numberOfTimers; i++) {
+		timers[i] = setUpTimer(MILLISECONDS(getRandomTimeout()));
+	}
+	startTime = readClock();
+	endTime = startTime + SECONDS(runDuration);
+	do {
+		updateCurrentTime();
+		updateTimers();
+		for (int i = 0; i < numberOfTimers; i++) {
+			if (isTimerElapsed(timers[i])) {
+				timers[i] = setUpTimer(MILLISECONDS(getRandomTimeout()));
+				result->expirations++;
+			}
+		}
+		result->iterations++;
+	} while (readClock() < endTime);
+	result->runTime = readClock() - startTime;
+
+	for (int i = 0; i < numberOfTimers; i++) {
+		abortTimer(timers[i]);
+	}
+}
+
+/**
+ * Re-arm an elapsed callback timer
+ *
+ * @param context Pointer to the handle of the timer
+ */
+static void rearmCallbackTimer(void *context)
+{
+	TIMER *timer = context;
+
+	*timer = setUpCallbackTimer(MILLISECONDS(getRandomTimeout()), 0, &rearmCallbackTimer, timer);
+	callbackExpirations++;
+}
+
+/**
+ * Benchmark the timing wheel with callbacks
+ */
+static void benchCallbackTimers(BenchResult *result)
+{
+	TIME startTime, endTime;
+
+	benchWheelArmAndCancel(result);
+
+	updateCurrentTime();
+	for (int i = 0; i < numberOfTimers; i++) {
+		timers[i] = setUpCallbackTimer(MILLISECONDS(getRandomTimeout()), 0, &rearmCallbackTimer, &timers[i]);
+	}
+	callbackExpirations = 0;
+	startTime = readClock();
+	endTime = startTime + SECONDS(runDuration);
+	do {
+		updateCurrentTime();
+		updateTimers();
+		result->iterations++;
+	} while (readClock() < endTime);
+	result->runTime = readClock() - startTime;
+	result->expirations = callbackExpirations;
+
+	for (int i = 0; i < numberOfTimers; i++) {
+		abortTimer(timers[i]);
+	}
+}
+
+/**
+ * Print the result of a benchmark
+ */
+static void printResult(const BenchResult *result)
+{
+	UINT64 armCount = (UINT64) ARM_ROUNDS * numberOfTimers;
+
+	printf("%-18s %10llu %10llu %14llu %12lu %12lu\n", result->name,
+			result->armTime / armCount, result->cancelTime / armCount,
+			result->iterations ? result->runTime / result->iterations : 0,
+			result->expirations, result->iterations);
+}
+
+/**
+ * Run the benchmarks
+ */
+int main(int argc, char **argv)
+{
+	BenchResult results[] = {
+		{ .name = "malloc, polled" },
+		{ .name = "wheel, polled" },
+		{ .name = "wheel, callbacks" }
+	};
+
+	if (argc > 1) {
+		numberOfTimers = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		runDuration = atoi(argv[2]);
+	}
+	if (numberOfTimers < 1 || numberOfTimers > MAX_TIMERS || runDuration < 1) {
+		printf("Usage: %s [number of timers (1 to %d)] [seconds per run]\n", argv[0], MAX_TIMERS);
+		return 1;
+	}
+	benchMallocTimers(&results[0]);
+	benchWheelTimers(&results[1]);
+	benchCallbackTimers(&results[2]);
+
+	printf("Timer benchmark: %d live timers, timeouts %d to %d ms, %d s per run\n",
+			numberOfTimers, MIN_TIMEOUT, MAX_TIMEOUT, runDuration);
+	printf("%-18s %10s %10s %14s %12s %12s\n", "",
+			"arm [ns]", "abort [ns]", "iteration [ns]", "expirations", "iterations");
+	for (int i = 0; i < sizeof(results) / sizeof(results[0]); i++) {
+		printResult(&results[i]);
+	}
+	return 0;
+}
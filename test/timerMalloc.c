@@ -0,0 +1,76 @@
+/**
+ * @brief   The timers before the timing wheel (for the benchmark)
+ * @file    timerMalloc.c
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#include <stdlib.h>
+#include <sys/time.h>
+#include "defines.h"
+#include "timerMalloc.h"
+
+typedef struct {
+	unsigned long startTime;
+	unsigned long endTime;
+} TimerDescriptor;
+
+/**
+ * @copydoc setUpMallocTimer
+ */
+MALLOC_TIMER setUpMallocTimer(unsigned int time) {
+	TimerDescriptor *timerDescriptor = malloc(sizeof(TimerDescriptor));
+	struct timeval tv;
+
+	if (timerDescriptor == NULL) {
+		return NULL;
+	}
+
+	// get current time as timeval structure:
+	gettimeofday(&tv, NULL);
+
+	// get time in milliseconds and save it as start time:
+	timerDescriptor->startTime = (tv.tv_sec*1000) + (tv.tv_usec/1000);
+	// set end time:
+	timerDescriptor->endTime = timerDescriptor->startTime + time;
+	// return structure:
+	return timerDescriptor;
+}
+
+/**
+ * @copydoc abortMallocTimer
+ */
+void abortMallocTimer(MALLOC_TIMER timer) {
+	if (timer == NULL) {
+		return;
+	}
+
+	free(timer);
+}
+
+/**
+ * @copydoc isMallocTimerElapsed
+ */
+int isMallocTimerElapsed(MALLOC_TIMER timer) {
+	struct timeval tv;
+	unsigned long curTime;
+
+	if (timer == NULL) {
+		return FALSE;
+	}
+
+	TimerDescriptor *td = timer;
+
+	// get current time as timeval structure:
+	gettimeofday(&tv, NULL);
+
+	// get time in milliseconds and save it as start time:
+	curTime = (tv.tv_sec*1000) + (tv.tv_usec/1000);
+	// check if timer is elapsed:
+	if (curTime >= td->endTime) {
+		free(td);
+		return TRUE;
+	}
+	return FALSE;
+}
@@ -0,0 +1,45 @@
+/**
+ * @brief   The timers before the timing wheel (for the benchmark)
+ *
+ * Every timer is allocated with malloc and every check reads the wall
+ * clock. Only the names differ from the original timer.c, so both
+ * implementations can be linked into the same benchmark.
+ *
+ * @file    timerMalloc.h
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ */
+
+#ifndef TIMERMALLOC_H_
+#define TIMERMALLOC_H_
+
+/**
+ * Void pointer as handle to the TimerDescriptor structure.
+ */
+typedef void* MALLOC_TIMER;
+
+/**
+ * Set up timer
+ *
+ * @param time Time in milliseconds
+ * @return Returns pointer to timer description structure
+ */
+extern MALLOC_TIMER setUpMallocTimer(unsigned int time);
+
+/**
+ * Free timer descriptor structure
+ *
+ * @param timer Pointer to timer descriptor structure
+ */
+extern void abortMallocTimer(MALLOC_TIMER timer);
+
+/**
+ * Check if timer is elapsed (frees the timer if it is)
+ *
+ * @param timer Pointer Timer descriptor structure
+ * @return Returns TRUE if time is elapsed and FALSE if not
+ */
+extern int isMallocTimerElapsed(MALLOC_TIMER timer);
+
+#endif /* TIMERMALLOC_H_ */
@@ -0,0 +1,543 @@
+/**
+ * @brief   Stress test of the timers
+ * @file    timerTest.c
+ * @version 1.0
+ * @author  agent (agent@local)
+ * @date    Oct 17, 2026
+ *
+ * Arms, aborts and expires millions of timers in random order on a virtual
+ * clock, which stands in for the time base, and checks every step against a model of the timers. The time
+ * jumps by random amounts, to the next deadline or far ahead, so the
+ * timers pass through all levels of the timing wheel and the overflow
+ * list. Handlers re-arm timers and abort their own periodic timer, like
+ * the clients of the timers do.
+ *
+ * The pool is small (see the Makefile), so the descriptors are reused all
+ * the time and their generations wrap around. Every released handle must
+ * be rejected as stale until the generation of its descriptor wraps.
+ *
+ * Usage: yacm_test [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "defines.h"
+#include "types.h"
+#include "timebase.h"
+#include "timer.h"
+
+/**
+ * Number of random operations (arm, abort or update)
+ */
+#define NUM_OF_OPERATIONS	4000000
+
+/**
+ * Number of recently released handles which are checked for staleness
+ */
+#define NUM_OF_STALE_HANDLES	256
+
+/**
+ * Handle layout (see TIMER)
+ */
+#define HANDLE_INDEX(timer)			((timer) & 0xffff)
+#define HANDLE_GENERATION(timer)	((timer) >> 16)
+#define MAX_GENERATION				0xffff
+
+/**
+ * The timer resolution
+ */
+#define TICK_DURATION	MICROSECONDS(1)
+
+/**
+ * Kinds of timers
+ */
+enum TimerKind {
+	kind_polled = 0, /**< Polled with isTimerElapsed() */
+	kind_callback,   /**< One-shot callback timer */
+	kind_periodic    /**< Periodic callback timer */
+};
+
+/**
+ * The model of a running timer
+ */
+typedef struct {
+	TIMER timer;              /**< The handle or INVALID_TIMER if not running */
+	enum TimerKind kind;      /**< The kind of timer */
+	UINT64 endTick;           /**< End tick as set up (advanced by the periods) */
+	UINT64 dueTick;           /**< Tick at which the timer has to elapse */
+	UINT64 period;            /**< Period in ticks */
+	unsigned long lastUpdate; /**< Update in which the handler was called last */
+} ModelTimer;
+
+static ModelTimer modelTimers[MAX_TIMERS];
+static ModelTimer *descriptorOwners[MAX_TIMERS];
+static int numberOfRunningTimers = 0;
+
+static TIMER staleHandles[NUM_OF_STALE_HANDLES];
+static int numberOfStaleHandles = 0;
+static int nextStaleHandle = 0;
+
+// The tick of the current time during the last update:
+static UINT64 currentTick;
+// The first tick which the wheel has not processed (while a handler is
+// called, the tick after the one being processed):
+static UINT64 wheelTick;
+static unsigned long numberOfUpdates = 0;
+static unsigned long operation = 0;
+
+// Statistics
+static unsigned long arms = 0;
+static unsigned long aborts = 0;
+static unsigned long expirations = 0;
+static unsigned long staleChecks = 0;
+
+static UINT64 randomState;
+
+// The virtual clock:
+static TIME virtualTime = 0;
+
+/**
+ * @copydoc updateCurrentTime
+ */
+TIME updateCurrentTime(void)
+{
+	return virtualTime;
+}
+
+/**
+ * @copydoc getCurrentTime
+ */
+TIME getCurrentTime(void)
+{
+	return virtualTime;
+}
+
+/**
+ * Get a random number (xorshift64*)
+ */
+static UINT64 getRandom(void)
+{
+	randomState ^= randomState >> 12;
+	randomState ^= randomState << 25;
+	randomState ^= randomState >> 27;
+	return randomState * 2685821657736338717ULL;
+}
+
+/**
+ * Report a failed check and stop the test
+ *
+ * @param message What went wrong
+ * @param timer The handle concerned
+ */
+static void fail(const char *message, TIMER timer)
+{
+	printf("Timer test failed after %lu operations: %s (timer 0x%08lx, tick %llu)\n",
+			operation, message, timer, currentTick);
+	exit(1);
+}
+
+/**
+ * Get a random duration of any order of magnitude
+ */
+static TIME getRandomDuration(void)
+{
+	switch (getRandom() % 8) {
+	case 0:
+		return 0;
+	case 1:
+		return getRandom() % MICROSECONDS(1);
+	case 2:
+		return getRandom() % MICROSECONDS(64);
+	case 3:
+		return getRandom() % MILLISECONDS(4);
+	case 4:
+		return getRandom() % SECONDS(1);
+	case 5:
+		return getRandom() % SECONDS(300);
+	case 6:
+		// beyond the range of the wheel (about 19 hours):
+		return getRandom() % SECONDS(48 * 3600);
+	default:
+		return getRandom() % MILLISECONDS(100);
+	}
+}
+
+/**
+ * Remember a released handle
+ */
+static void addStaleHandle(TIMER timer)
+{
+	staleHandles[nextStaleHandle] = timer;
+	nextStaleHandle = (nextStaleHandle + 1) % NUM_OF_STALE_HANDLES;
+	if (numberOfStaleHandles < NUM_OF_STALE_HANDLES) {
+		numberOfStaleHandles++;
+	}
+}
+
+/**
+ * Get one of the recently released handles
+ */
+static TIMER getStaleHandle(void)
+{
+	if (numberOfStaleHandles == 0) {
+		return INVALID_TIMER;
+	}
+	return staleHandles[getRandom() % numberOfStaleHandles];
+}
+
+/**
+ * Remove a timer from the model after it was released
+ */
+static void releaseModelTimer(ModelTimer *modelTimer)
+{
+	descriptorOwners[HANDLE_INDEX(modelTimer->timer)] = NULL;
+	addStaleHandle(modelTimer->timer);
+	modelTimer->timer = INVALID_TIMER;
+	numberOfRunningTimers--;
+}
+
+static void armTimer(enum TimerKind kind);
+
+/**
+ * Handler of the callback timers
+ *
+ * @param context Pointer to the model of the timer
+ */
+static void handleTimer(void *context)
+{
+	ModelTimer *modelTimer = context;
+	UINT64 processedTick = modelTimer->dueTick;
+
+	if (modelTimer->timer == INVALID_TIMER) {
+		fail("handler of a released timer called", INVALID_TIMER);
+	}
+	if (modelTimer->dueTick > currentTick) {
+		fail("handler called early", modelTimer->timer);
+	}
+	if (modelTimer->lastUpdate == numberOfUpdates) {
+		fail("handler called twice in one update", modelTimer->timer);
+	}
+	modelTimer->lastUpdate = numberOfUpdates;
+	expirations++;
+
+	// the wheel is processing the due tick:
+	wheelTick = processedTick + 1;
+
+	if (modelTimer->kind == kind_periodic) {
+		// missed periods are skipped:
+		modelTimer->endTick += modelTimer->period;
+		if (modelTimer->endTick <= currentTick) {
+			modelTimer->endTick += ((currentTick - modelTimer->endTick) / modelTimer->period + 1)
+					* modelTimer->period;
+		}
+		modelTimer->dueTick = modelTimer->endTick;
+		if (isTimerElapsed(modelTimer->timer)) {
+			fail("periodic timer not running in its handler", modelTimer->timer);
+		}
+
+		// sometimes the handler aborts its own timer:
+		if (getRandom() % 8 == 0) {
+			abortTimer(modelTimer->timer);
+			aborts++;
+			releaseModelTimer(modelTimer);
+		}
+	} else {
+		if (!isTimerElapsed(modelTimer->timer)) {
+			fail("one-shot timer still running in its handler", modelTimer->timer);
+		}
+		releaseModelTimer(modelTimer);
+	}
+
+	// sometimes the handler sets up a new timer:
+	if (getRandom() % 4 == 0 && numberOfRunningTimers < MAX_TIMERS) {
+		armTimer(getRandom() % 3);
+	}
+}
+
+/**
+ * Set up a timer and add it to the model
+ *
+ * @param kind The kind of timer
+ */
+static void armTimer(enum TimerKind kind)
+{
+	TIME duration = getRandomDuration();
+	TIME period = kind == kind_periodic ? getRandom() % MILLISECONDS(50) + 1 : 0;
+	UINT64 endTick = (getCurrentTime() + duration + TICK_DURATION - 1) / TICK_DURATION;
+	ModelTimer *modelTimer = NULL;
+	ModelTimer *owner;
+	TIMER timer;
+
+	for (int i = 0; i < MAX_TIMERS; i++) {
+		if (modelTimers[i].timer == INVALID_TIMER) {
+			modelTimer = &modelTimers[i];
+			break;
+		}
+	}
+	if (modelTimer == NULL) {
+		fail("model has no free timer", INVALID_TIMER);
+	}
+
+	if (kind == kind_polled) {
+		timer = setUpTimer(duration);
+	} else {
+		timer = setUpCallbackTimer(duration, period, &handleTimer, modelTimer);
+	}
+	arms++;
+
+	if (timer == INVALID_TIMER) {
+		fail("no timer although the pool is not exhausted", timer);
+	}
+	if (HANDLE_INDEX(timer) >= MAX_TIMERS || HANDLE_GENERATION(timer) == 0) {
+		fail("invalid handle", timer);
+	}
+	owner = descriptorOwners[HANDLE_INDEX(timer)];
+	// a handler may get the descriptor of a polled timer which elapsed
+	// during the same update:
+	if (owner && owner->kind == kind_polled && owner->dueTick <= currentTick
+			&& isTimerElapsed(owner->timer)) {
+		expirations++;
+		releaseModelTimer(owner);
+		owner = NULL;
+	}
+	if (owner) {
+		fail("descriptor of a running timer handed out", timer);
+	}
+
+	// a polled timer whose tick is already processed has elapsed right away:
+	if (kind == kind_polled && endTick < wheelTick) {
+		if (!isTimerElapsed(timer)) {
+			fail("timer in the past not elapsed", timer);
+		}
+		addStaleHandle(timer);
+		return;
+	}
+
+	modelTimer->timer = timer;
+	modelTimer->kind = kind;
+	modelTimer->endTick = endTick;
+	modelTimer->dueTick = endTick < wheelTick ? wheelTick : endTick;
+	modelTimer->period = (period + TICK_DURATION - 1) / TICK_DURATION;
+	modelTimer->lastUpdate = 0;
+	descriptorOwners[HANDLE_INDEX(timer)] = modelTimer;
+	numberOfRunningTimers++;
+
+	if (isTimerElapsed(timer)) {
+		fail("new timer elapsed", timer);
+	}
+}
+
+/**
+ * Abort a random running timer
+ */
+static void abortRandomTimer(void)
+{
+	int start = getRandom() % MAX_TIMERS;
+
+	for (int i = 0; i < MAX_TIMERS; i++) {
+		ModelTimer *modelTimer = &modelTimers[(start + i) % MAX_TIMERS];
+
+		if (modelTimer->timer != INVALID_TIMER) {
+			TIMER timer = modelTimer->timer;
+
+			abortTimer(timer);
+			aborts++;
+			releaseModelTimer(modelTimer);
+			if (!isTimerElapsed(timer)) {
+				fail("aborted timer not elapsed", timer);
+			}
+			return;
+		}
+	}
+}
+
+/**
+ * Use a released handle (must have no effect)
+ */
+static void useStaleHandle(void)
+{
+	TIMER timer = getStaleHandle();
+
+	if (timer == INVALID_TIMER) {
+		return;
+	}
+	if (!isTimerElapsed(timer)) {
+		fail("stale handle not elapsed", timer);
+	}
+	// must not abort the timer which reuses the descriptor:
+	abortTimer(timer);
+	staleChecks++;
+}
+
+/**
+ * Check the running timers against the model after an update
+ */
+static void checkTimers(void)
+{
+	UINT64 nextDueTick = NO_TIME;
+	TIME deadline;
+
+	for (int i = 0; i < MAX_TIMERS; i++) {
+		ModelTimer *modelTimer = &modelTimers[i];
+
+		if (modelTimer->timer == INVALID_TIMER) {
+			continue;
+		}
+		if (modelTimer->dueTick <= currentTick) {
+			if (modelTimer->kind != kind_polled) {
+				fail("handler not called", modelTimer->timer);
+			}
+			if (!isTimerElapsed(modelTimer->timer)) {
+				fail("timer not elapsed", modelTimer->timer);
+			}
+			expirations++;
+			releaseModelTimer(modelTimer);
+			continue;
+		}
+		if (isTimerElapsed(modelTimer->timer)) {
+			fail("timer elapsed early", modelTimer->timer);
+		}
+		if (modelTimer->dueTick < nextDueTick) {
+			nextDueTick = modelTimer->dueTick;
+		}
+	}
+
+	// the loop must not sleep past the next due timer:
+	deadline = getNextTimerDeadline();
+	if (numberOfRunningTimers == 0) {
+		if (deadline != NO_TIME) {
+			fail("deadline without running timers", INVALID_TIMER);
+		}
+	} else if (deadline <= currentTick * TICK_DURATION || deadline > nextDueTick * TICK_DURATION) {
+		fail("wrong deadline", INVALID_TIMER);
+	}
+}
+
+/**
+ * Let the time advance and update the timers
+ */
+static void updateModel(void)
+{
+	TIME now = getCurrentTime();
+	TIME deadline = getNextTimerDeadline();
+
+	switch (getRandom() % 8) {
+	case 0:
+	case 1:
+	case 2:
+		// to the next deadline, sometimes a bit later:
+		if (deadline != NO_TIME) {
+			now = deadline + (getRandom() % 2 ? getRandom() % MICROSECONDS(3) : 0);
+		}
+		break;
+	case 3:
+		// far ahead:
+		now += getRandom() % SECONDS(24 * 3600);
+		break;
+	case 4:
+		now += getRandom() % MILLISECONDS(100);
+		break;
+	default:
+		now += getRandom() % MICROSECONDS(10);
+		break;
+	}
+	virtualTime = now;
+
+	currentTick = getCurrentTime() / TICK_DURATION;
+	numberOfUpdates++;
+	updateTimers();
+	wheelTick = currentTick + 1;
+
+	checkTimers();
+}
+
+/**
+ * Exhaust the pool
+ */
+static void testPoolExhaustion(void)
+{
+	TIMER timers[MAX_TIMERS];
+
+	for (int i = 0; i < MAX_TIMERS; i++) {
+		timers[i] = setUpTimer(SECONDS(1));
+		if (timers[i] == INVALID_TIMER) {
+			fail("pool exhausted early", INVALID_TIMER);
+		}
+	}
+	if (setUpTimer(SECONDS(1)) != INVALID_TIMER) {
+		fail("timer set up from an exhausted pool", INVALID_TIMER);
+	}
+	for (int i = 0; i < MAX_TIMERS; i++) {
+		abortTimer(timers[i]);
+	}
+}
+
+/**
+ * Reuse one descriptor until its generation wraps around twice
+ */
+static void testGenerationWrap(void)
+{
+	TIMER previous = setUpTimer(SECONDS(1));
+
+	abortTimer(previous);
+	for (long i = 0; i < 2L * MAX_GENERATION + 1; i++) {
+		// the last released descriptor is reused first:
+		TIMER timer = setUpTimer(SECONDS(1));
+		UINT32 generation = HANDLE_GENERATION(previous) % MAX_GENERATION + 1;
+
+		if (HANDLE_INDEX(timer) != HANDLE_INDEX(previous) || HANDLE_GENERATION(timer) != generation) {
+			fail("unexpected generation", timer);
+		}
+		if (!isTimerElapsed(previous)) {
+			fail("stale handle of a reused descriptor not elapsed", previous);
+		}
+		abortTimer(previous);
+		if (isTimerElapsed(timer)) {
+			fail("stale handle aborted the reused descriptor", timer);
+		}
+		abortTimer(timer);
+		previous = timer;
+	}
+}
+
+/**
+ * Run the test
+ */
+int main(int argc, char **argv)
+{
+	UINT64 seed = argc > 1 ? strtoull(argv[1], NULL, 0) : 1;
+
+	randomState = seed ? seed : 1;
+	currentTick = getCurrentTime() / TICK_DURATION;
+	updateTimers();
+	wheelTick = currentTick + 1;
+
+	testPoolExhaustion();
+	testGenerationWrap();
+
+	for (operation = 0; operation < NUM_OF_OPERATIONS; operation++) {
+		unsigned int choice = getRandom() % 100;
+
+		if (choice < 60 && numberOfRunningTimers == MAX_TIMERS) {
+			choice = 60;
+		}
+		if (choice < 30) {
+			armTimer(kind_polled);
+		} else if (choice < 45) {
+			armTimer(kind_callback);
+		} else if (choice < 50) {
+			armTimer(kind_periodic);
+		} else if (choice < 70) {
+			abortRandomTimer();
+		} else if (choice < 75) {
+			useStaleHandle();
+		} else {
+			updateModel();
+		}
+	}
+
+	printf("Timer test passed (seed %llu): %lu arms, %lu aborts, %lu expirations, "
+			"%lu stale handles rejected, %lu updates\n",
+			seed, arms, aborts, expirations, staleChecks, numberOfUpdates);
+	return 0;
+}